@@ -0,0 +1,75 @@
+// Compares virtual and kind-dispatched calorie evaluation over a large synthetic catalog.
+//
+//   food_dispatch_bench [basic foods] [composites] [rounds]
+//
+// Both loops must produce the same checksum; the time per food is what differs.
+
+#include "food/BasicFood.h"
+#include "food/CompositeFood.h"
+#include "food/FoodDispatch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::shared_ptr<Food>> makeCatalog(size_t basicCount, size_t compositeCount) {
+    std::mt19937 random(42);
+    std::vector<std::shared_ptr<Food>> foods;
+    foods.reserve(basicCount + compositeCount);
+    for (size_t i = 0; i < basicCount; ++i) {
+        foods.push_back(std::make_shared<BasicFood>("food_" + std::to_string(i), std::vector<std::string>{"bench"},
+                                                    static_cast<double>(random() % 500 + 5)));
+    }
+    // Composites use 2-6 earlier foods, so some of them contain other composites
+    for (size_t i = 0; i < compositeCount; ++i) {
+        auto composite = std::make_shared<CompositeFood>("meal_" + std::to_string(i), std::vector<std::string>{"bench"});
+        size_t components = 2 + random() % 5;
+        for (size_t c = 0; c < components; ++c) {
+            composite->addComponent(foods[random() % foods.size()], static_cast<double>(1 + random() % 3));
+        }
+        foods.push_back(composite);
+    }
+    // Mix the kinds the way a catalog map ordered by ID would
+    std::shuffle(foods.begin(), foods.end(), random);
+    return foods;
+}
+
+template <typename Evaluate>
+double run(const char* label, const std::vector<std::shared_ptr<Food>>& foods, size_t rounds, Evaluate evaluate) {
+    double checksum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (const auto& food : foods) {
+            checksum += evaluate(*food);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-10s %10.2f ns/food   checksum %.6f\n", label, elapsed.count() / (rounds * foods.size()), checksum);
+    return checksum;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t basicCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t compositeCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 50000;
+    size_t rounds = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20;
+
+    auto foods = makeCatalog(basicCount, compositeCount);
+    std::printf("%zu basic foods, %zu composites, %zu rounds\n", basicCount, compositeCount, rounds);
+
+    double virtualSum = run("virtual", foods, rounds, [](const Food& food) { return food.getCaloriesPerServing(); });
+    double staticSum = run("static", foods, rounds, [](const Food& food) { return caloriesOf(food); });
+
+    if (virtualSum != staticSum) {
+        std::printf("Checksums differ\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Compares per-profile and batch target-calorie computation over a synthetic cohort.
+//
+//   target_batch_bench [profiles] [rounds]
+//
+// Every batch target must equal the scalar one bit for bit; the time per profile is what differs.
+
+#include "diet_goal/CalorieTargetBatch.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+ProfileColumns makeCohort(size_t count) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> weights(35.0, 180.0);
+    std::uniform_real_distribution<double> heights(120.0, 215.0);
+    ProfileColumns profiles;
+    profiles.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        profiles.add(random() % 2 ? Gender::MALE : Gender::FEMALE, weights(random), heights(random),
+                     static_cast<int>(15 + random() % 80), static_cast<ActivityLevel>(random() % 5),
+                     static_cast<int>(1 + random() % 2));
+    }
+    return profiles;
+}
+
+template <typename Compute>
+double run(const char* label, size_t count, size_t rounds, Compute compute) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        compute();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    double perRound = elapsed.count() / rounds;
+    std::printf("%-8s %8.3f ms/round  %6.2f ns/profile\n", label, perRound, perRound * 1e6 / count);
+    return perRound;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+    ProfileColumns profiles = makeCohort(count);
+    std::printf("%zu profiles, %zu rounds\n", count, rounds);
+
+    std::vector<double> scalarTargets(count);
+    std::vector<double> batchTargets(count);
+    run("scalar", count, rounds, [&] {
+        for (size_t i = 0; i < count; ++i) {
+            scalarTargets[i] = CalorieTargetBatch::calculateOne(profiles, i);
+        }
+    });
+    run("batch", count, rounds, [&] { CalorieTargetBatch::calculate(profiles, batchTargets.data()); });
+
+    if (std::memcmp(scalarTargets.data(), batchTargets.data(), count * sizeof(double)) != 0) {
+        std::printf("Batch targets differ from the scalar ones\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "LogAnalytics.h"
+#include "daily_log/LogArchive.h"
+#include "food/FoodDispatch.h"
+#include "utils/DateUtils.h"
+#include "utils/FileHandler.h"
+#include "utils/Tracer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string_view>
+
+namespace {
+
+struct DayTotal
+{
+    double calories;
+    int entries;
+};
+
+// Fold per-user summaries the same way the aggregator folds days
+void accumulate(CalorieSummary &into, const CalorieSummary &from) {
+    if (from.days == 0) {
+        return;
+    }
+    into.minimum = into.days == 0 ? from.minimum : std::min(into.minimum, from.minimum);
+    into.maximum = into.days == 0 ? from.maximum : std::max(into.maximum, from.maximum);
+    into.days += from.days;
+    into.total += from.total;
+    into.average = into.total / into.days;
+}
+
+} // namespace
+
+LogAnalytics::LogAnalytics(const FoodDatabase &db, ThreadPool &pool) : m_db(db), m_pool(pool) {}
+
+bool LogAnalytics::scanFile(const std::string &path, int firstDay, int lastDay, CalorieSummary &summary) const {
+    TRACE_SCOPE("LogAnalytics::scanFile");
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Same rules as LogManager::loadLogs: a repeated date header starts the day over, entries
+    // under an invalid date are skipped, and unknown foods are ignored
+    std::map<std::string, double, std::less<>> calories; // Per-file memo, NaN for unknown foods
+    std::map<int, DayTotal> days;
+    DayTotal *current = nullptr;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string_view view(line);
+        if (view.substr(0, 6) == "DATE: ") {
+            int dayNumber;
+            current = nullptr;
+            if (DateUtils::toDayNumber(view.substr(6), dayNumber) && dayNumber >= firstDay && dayNumber <= lastDay) {
+                current = &days[dayNumber];
+                *current = {0.0, 0};
+            }
+            continue;
+        }
+        if (!current || view.empty()) {
+            continue;
+        }
+
+        size_t comma = view.find(',');
+        if (comma == std::string_view::npos) {
+            continue;
+        }
+        const char *servingsStart = line.c_str() + comma + 1;
+        char *servingsEnd = nullptr;
+        double servings = std::strtod(servingsStart, &servingsEnd);
+        if (servingsEnd == servingsStart) {
+            continue;
+        }
+
+        std::string_view foodId = view.substr(0, comma);
+        auto it = calories.find(foodId);
+        if (it == calories.end()) {
+            auto food = m_db.getFoodById(foodId);
+            double perServing = food ? caloriesOf(*food) : std::nan("");
+            it = calories.emplace(std::string(foodId), perServing).first;
+        }
+        if (!std::isnan(it->second)) {
+            current->calories += it->second * servings;
+            ++current->entries;
+        }
+    }
+
+    // Archived days count unless the text log has the same date
+    LogArchive archive;
+    if (archive.load(LogArchive::pathFor(path), m_db)) {
+        archive.forEachDayTotal([&days, firstDay, lastDay](int dayNumber, double calories) {
+            if (dayNumber >= firstDay && dayNumber <= lastDay && days.count(dayNumber) == 0) {
+                days[dayNumber] = {calories, 1};
+            }
+        });
+    }
+
+    summary = CalorieSummary();
+    for (const auto &[dayNumber, day] : days) {
+        if (day.entries > 0) {
+            accumulate(summary, {1, day.calories, day.calories, day.calories, day.calories});
+        }
+    }
+    return true;
+}
+
+FleetCalorieReport LogAnalytics::run(const std::vector<LogSource> &sources, int firstDay, int lastDay) {
+    TRACE_SCOPE("LogAnalytics::run");
+    auto start = std::chrono::steady_clock::now();
+
+    FleetCalorieReport report;
+    report.users.resize(sources.size());
+    std::atomic<size_t> failed(0);
+
+    // One task per file; each writes only its own slot
+    for (size_t i = 0; i < sources.size(); ++i) {
+        m_pool.submit([this, &sources, &report, &failed, i, firstDay, lastDay] {
+            report.users[i].userId = sources[i].userId;
+            if (!scanFile(sources[i].path, firstDay, lastDay, report.users[i].summary)) {
+                ++failed;
+            }
+        });
+    }
+    m_pool.wait();
+
+    size_t activeUsers = 0;
+    double sumOfAverages = 0.0;
+    for (const auto &user : report.users) {
+        accumulate(report.allDays, user.summary);
+        if (user.summary.days > 0) {
+            ++activeUsers;
+            sumOfAverages += user.summary.average;
+        }
+    }
+    report.averageOfUserAverages = activeUsers > 0 ? sumOfAverages / activeUsers : 0.0;
+    report.filesFailed = failed;
+    report.filesScanned = sources.size() - report.filesFailed;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+std::vector<LogSource> LogAnalytics::discover(const std::string &dataDirectory) {
+    std::vector<LogSource> sources;
+    if (FileHandler::fileExists(dataDirectory + "/daily_logs.txt")) {
+        sources.push_back({"(shared)", dataDirectory + "/daily_logs.txt"});
+    }
+
+    // Per-user logs live in <data>/users/<bucket>/<user>/daily_logs.txt
+    std::string usersDirectory = dataDirectory + "/users";
+    for (const auto &bucket : FileHandler::listDirectories(usersDirectory)) {
+        for (const auto &userId : FileHandler::listDirectories(usersDirectory + "/" + bucket)) {
+            std::string path = usersDirectory + "/" + bucket + "/" + userId + "/daily_logs.txt";
+            if (FileHandler::fileExists(path)) {
+                sources.push_back({userId, path});
+            }
+        }
+    }
+
+    std::sort(sources.begin(), sources.end(), [](const LogSource &a, const LogSource &b) {
+        return a.userId < b.userId;
+    });
+    return sources;
+}
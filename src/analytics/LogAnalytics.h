@@ -0,0 +1,59 @@
+#ifndef LOG_ANALYTICS_H
+#define LOG_ANALYTICS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "database/FoodDatabase.h"
+#include "daily_log/CalorieAggregator.h"
+#include "utils/ThreadPool.h"
+
+// A log file to scan and the user it belongs to
+struct LogSource
+{
+    std::string userId;
+    std::string path;
+};
+
+// Calorie aggregates of one user's logged days in the requested range
+struct UserCalorieReport
+{
+    std::string userId;
+    CalorieSummary summary;
+};
+
+// Aggregates for every scanned user plus the fleet as a whole
+struct FleetCalorieReport
+{
+    std::vector<UserCalorieReport> users; // Same order as the sources
+    CalorieSummary allDays;               // Over every logged user-day
+    double averageOfUserAverages = 0.0;   // Mean of the per-user daily averages
+    size_t filesScanned = 0;
+    size_t filesFailed = 0;
+    double seconds = 0.0;
+};
+
+// Whole-history calorie analytics over many log files at once.
+// Files are parsed line by line straight into per-day totals (no DailyLog objects), one
+// task per file on a work-stealing pool, so memory stays bounded by the number of workers
+// times the logged days of one file.
+class LogAnalytics
+{
+public:
+    LogAnalytics(const FoodDatabase &db, ThreadPool &pool);
+
+    // Scan every source and aggregate the days in [firstDay, lastDay] (day numbers)
+    FleetCalorieReport run(const std::vector<LogSource> &sources, int firstDay, int lastDay);
+
+    // Aggregate one file's days in [firstDay, lastDay], plus its archive's; false if the file can't be read
+    bool scanFile(const std::string &path, int firstDay, int lastDay, CalorieSummary &summary) const;
+
+    // Find the shared log in dataDirectory and every per-user log under dataDirectory/users
+    static std::vector<LogSource> discover(const std::string &dataDirectory);
+
+private:
+    const FoodDatabase &m_db;
+    ThreadPool &m_pool;
+};
+
+#endif // LOG_ANALYTICS_H
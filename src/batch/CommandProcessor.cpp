@@ -0,0 +1,372 @@
+#include "CommandProcessor.h"
+#include "utils/DateUtils.h"
+#include "utils/FileHandler.h"
+#include <charconv>
+#include <exception>
+
+namespace {
+
+// Longest range "target <from> <to>" prints, about five years; one line is built per day
+const int MAX_TARGET_DAYS = 5 * 366;
+
+// Split on runs of spaces and tabs, reusing the token vector's storage
+void tokenize(std::string_view line, std::vector<std::string_view> &tokens) {
+    tokens.clear();
+    size_t pos = 0;
+    while (pos < line.size()) {
+        size_t start = line.find_first_not_of(" \t\r", pos);
+        if (start == std::string_view::npos) {
+            break;
+        }
+        size_t end = line.find_first_of(" \t\r", start);
+        if (end == std::string_view::npos) {
+            end = line.size();
+        }
+        tokens.push_back(line.substr(start, end - start));
+        pos = end;
+    }
+}
+
+bool parseNumber(std::string_view text, double &value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool parseIndex(std::string_view text, size_t &value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Same formatting as the menus' std::cout << double (6 significant digits)
+void appendNumber(std::string &out, double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+    out.append(buffer, result.ptr);
+}
+
+void appendFoodIds(std::string &out, const std::vector<std::shared_ptr<Food>> &foods) {
+    for (const auto &food : foods) {
+        out += food->getId();
+        out += '\n';
+    }
+}
+
+bool ok(std::string &out) {
+    out += "ok\n";
+    return true;
+}
+
+const char *const HELP_TEXT =
+    "log add <date> <food> <servings>\n"
+    "log remove <date> <index>\n"
+    "log show <date>\n"
+    "log stats <from> <to>\n"
+    "log undo\n"
+    "log redo\n"
+    "food add <id> <kw,kw,...> <calories>\n"
+    "food calories <id> <calories>\n"
+    "food show <id>\n"
+    "search any|all <keyword>...\n"
+    "query <expression>\n"
+    "target [date | <from> <to>]\n"
+    "save\n";
+
+} // namespace
+
+CommandProcessor::CommandProcessor(FoodDatabase &db, LogManager &logManager, DietGoalProfile &profile)
+    : m_db(db), m_logManager(logManager), m_profile(profile) {}
+
+bool CommandProcessor::execute(std::string_view line, std::string &out) {
+    Args &args = m_args;
+    tokenize(line, args);
+    if (args.empty() || args[0][0] == '#') {
+        return true;
+    }
+
+    std::string_view command = args[0];
+    try {
+        if (command == "log") {
+            return runLog(args, out);
+        }
+        if (command == "food") {
+            return runFood(args, out);
+        }
+        if (command == "search") {
+            return runSearch(args, out);
+        }
+        if (command == "query") {
+            // The expression is the rest of the line, spacing included
+            size_t start = static_cast<size_t>(command.data() - line.data()) + command.size();
+            return runQuery(line.substr(start), out);
+        }
+        if (command == "target" && args.size() <= 3) {
+            return runTarget(args, out);
+        }
+        if (command == "save" && args.size() == 1) {
+            return save() ? ok(out) : fail(out, "could not save");
+        }
+        if (command == "help") {
+            out += HELP_TEXT;
+            return ok(out);
+        }
+    } catch (const std::exception &e) {
+        return fail(out, e.what());
+    }
+    return fail(out, "unknown command (try help)");
+}
+
+bool CommandProcessor::runLog(const Args &args, std::string &out) {
+    std::string_view action = args.size() > 1 ? args[1] : std::string_view();
+
+    if (action == "add" && args.size() == 5) {
+        double servings;
+        if (!parseNumber(args[4], servings) || servings <= 0) {
+            return fail(out, "servings must be a positive number");
+        }
+        auto food = m_db.getFoodById(args[3]);
+        if (!food) {
+            return fail(out, "food not found");
+        }
+        if (!m_logManager.addFoodEntry(std::string(args[2]), food, servings)) {
+            return fail(out, "invalid date (use DD-MM-YYYY)");
+        }
+        m_unsaved = true;
+        return ok(out);
+    }
+
+    if (action == "remove" && args.size() == 4) {
+        size_t index;
+        if (!parseIndex(args[3], index) || index == 0) {
+            return fail(out, "index must be a positive integer");
+        }
+        if (!m_logManager.removeFoodEntry(std::string(args[2]), index - 1)) {
+            return fail(out, "no such entry");
+        }
+        m_unsaved = true;
+        return ok(out);
+    }
+
+    if (action == "show" && args.size() == 3) {
+        std::string date(args[2]);
+        if (!m_logManager.isValidDateFormat(date)) {
+            return fail(out, "invalid date (use DD-MM-YYYY)");
+        }
+        const DailyLog &log = m_logManager.getLog(date);
+        size_t i = 0;
+        for (const auto &[id, entry] : log.getFoodEntries()) {
+            appendNumber(out, static_cast<double>(++i));
+            out += ' ';
+            out += entry.getFood()->getId();
+            out += ' ';
+            appendNumber(out, entry.getServings());
+            out += ' ';
+            appendNumber(out, entry.getTotalCalories());
+            out += '\n';
+        }
+        out += "total ";
+        appendNumber(out, log.getTotalCalories());
+        out += '\n';
+        return ok(out);
+    }
+
+    if (action == "stats" && args.size() == 4) {
+        CalorieSummary summary;
+        if (!m_logManager.getCalorieSummary(std::string(args[2]), std::string(args[3]), summary)) {
+            return fail(out, "invalid date (use DD-MM-YYYY)");
+        }
+        out += "days ";
+        appendNumber(out, static_cast<double>(summary.days));
+        if (summary.days > 0) {
+            out += " total ";
+            appendNumber(out, summary.total);
+            out += " average ";
+            appendNumber(out, summary.average);
+            out += " min ";
+            appendNumber(out, summary.minimum);
+            out += " max ";
+            appendNumber(out, summary.maximum);
+        }
+        out += '\n';
+        return ok(out);
+    }
+
+    if (action == "undo" && args.size() == 2) {
+        std::string message;
+        if (!m_logManager.undo(message)) {
+            return fail(out, message);
+        }
+        m_unsaved = true;
+        return ok(out);
+    }
+
+    if (action == "redo" && args.size() == 2) {
+        std::string message;
+        if (!m_logManager.redo(message)) {
+            return fail(out, message);
+        }
+        m_unsaved = true;
+        return ok(out);
+    }
+
+    return fail(out, "usage: log add|remove|show|stats|undo|redo ...");
+}
+
+bool CommandProcessor::runFood(const Args &args, std::string &out) {
+    std::string_view action = args.size() > 1 ? args[1] : std::string_view();
+
+    if (action == "add" && args.size() == 5) {
+        double calories;
+        if (!parseNumber(args[4], calories) || calories < 0) {
+            return fail(out, "calories must be a non-negative number");
+        }
+        std::vector<std::string> keywords;
+        for (std::string_view rest = args[3]; !rest.empty();) {
+            size_t comma = rest.find(',');
+            std::string_view keyword = rest.substr(0, comma);
+            if (!keyword.empty()) {
+                keywords.emplace_back(keyword);
+            }
+            rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+        }
+        auto food = std::make_shared<BasicFood>(std::string(args[2]), keywords, calories);
+        if (!m_db.addBasicFood(food)) {
+            return fail(out, "a food with this ID already exists");
+        }
+        m_unsaved = true;
+        return ok(out);
+    }
+
+    if (action == "calories" && args.size() == 4) {
+        double calories;
+        if (!parseNumber(args[3], calories) || calories < 0) {
+            return fail(out, "calories must be a non-negative number");
+        }
+        if (!m_db.updateBasicFoodCalories(std::string(args[2]), calories)) {
+            return fail(out, "basic food not found");
+        }
+        // Logged days that use the food are re-priced
+        m_logManager.rebuildCalorieTotals();
+        m_unsaved = true;
+        return ok(out);
+    }
+
+    if (action == "show" && args.size() == 3) {
+        auto food = m_db.getFoodById(args[2]);
+        if (!food) {
+            return fail(out, "food not found");
+        }
+        out += food->toString();
+        out += '\n';
+        return ok(out);
+    }
+
+    return fail(out, "usage: food add|calories|show ...");
+}
+
+bool CommandProcessor::runSearch(const Args &args, std::string &out) {
+    if (args.size() < 3 || (args[1] != "any" && args[1] != "all")) {
+        return fail(out, "usage: search any|all <keyword>...");
+    }
+    std::vector<std::string> keywords(args.begin() + 2, args.end());
+    appendFoodIds(out, args[1] == "any" ? m_db.findFoodsMatchingAnyKeyword(keywords)
+                                        : m_db.findFoodsMatchingAllKeywords(keywords));
+    return ok(out);
+}
+
+bool CommandProcessor::runQuery(std::string_view expression, std::string &out) {
+    appendFoodIds(out, m_db.findFoodsMatchingQuery(std::string(expression)));
+    return ok(out);
+}
+
+bool CommandProcessor::runTarget(const Args &args, std::string &out) {
+    if (!m_profile.loaded()) {
+        return fail(out, "no diet profile");
+    }
+    if (args.size() == 1) {
+        out += "target ";
+        appendNumber(out, m_profile.calculateTargetCalories());
+        out += '\n';
+        return ok(out);
+    }
+    if (args.size() == 2) {
+        std::string date(args[1]);
+        int dayNumber;
+        if (!DateUtils::toDayNumber(date, dayNumber)) {
+            return fail(out, "invalid date (use DD-MM-YYYY)");
+        }
+        if (!m_profile.getProfileOn(date)) {
+            return fail(out, "no profile on or before that date");
+        }
+        out += "target ";
+        appendNumber(out, m_profile.calculateTargetCalories(date));
+        out += '\n';
+        return ok(out);
+    }
+
+    // One line per day, from the profile in effect that day
+    int firstDay;
+    int lastDay;
+    if (!DateUtils::toDayNumber(args[1], firstDay) || !DateUtils::toDayNumber(args[2], lastDay)) {
+        return fail(out, "invalid date range (use DD-MM-YYYY)");
+    }
+    if (lastDay - firstDay >= MAX_TARGET_DAYS) {
+        return fail(out, "date range too long (at most " + std::to_string(MAX_TARGET_DAYS) + " days)");
+    }
+    std::vector<double> targets;
+    if (!m_profile.calculateTargetCalories(std::string(args[1]), std::string(args[2]), targets)) {
+        return fail(out, "invalid date range (use DD-MM-YYYY)");
+    }
+    for (size_t i = 0; i < targets.size(); ++i) {
+        out += DateUtils::fromDayNumber(firstDay + static_cast<int>(i));
+        out += ' ';
+        appendNumber(out, targets[i]);
+        out += '\n';
+    }
+    return ok(out);
+}
+
+std::string_view CommandProcessor::commandOf(std::string_view line) {
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) {
+        return std::string_view();
+    }
+    size_t end = line.find_first_of(" \t\r", start);
+    return line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+}
+
+bool CommandProcessor::isReadOnly(std::string_view line) {
+    std::vector<std::string_view> args;
+    tokenize(line, args);
+    if (args.empty()) {
+        return true;
+    }
+    std::string_view command = args[0];
+    std::string_view action = args.size() > 1 ? args[1] : std::string_view();
+
+    // "log show" is not on the list: getLog may create the day or decode it from the archive
+    return command == "search" || command == "query" || command == "target" || command == "help" ||
+           (command == "food" && action == "show") || (command == "log" && action == "stats");
+}
+
+bool CommandProcessor::hasUnsavedChanges() const {
+    return m_unsaved;
+}
+
+bool CommandProcessor::save() {
+    try {
+        FileHandler::GroupCommit group;
+        if (m_db.saveFoods() && m_logManager.saveLogs() && m_profile.saveToFile() && group.commit()) {
+            m_unsaved = false;
+            return true;
+        }
+    } catch (const std::exception &) {
+    }
+    return false;
+}
+
+bool CommandProcessor::fail(std::string &out, std::string_view message) {
+    out += "error: ";
+    out += message;
+    out += '\n';
+    return false;
+}
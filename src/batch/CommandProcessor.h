@@ -0,0 +1,65 @@
+#ifndef COMMAND_PROCESSOR_H
+#define COMMAND_PROCESSOR_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "database/FoodDatabase.h"
+#include "daily_log/DailyLog.h"
+#include "diet_goal/DietGoalProfile.h"
+
+// Runs one-line text commands against a food database, a log and a diet profile.
+// Every command appends zero or more result lines to the output followed by a status
+// line, "ok" or "error: <reason>", so responses can be read back without prompts:
+//
+//   log add <date> <food> <servings>     log remove <date> <index>
+//   log show <date>                      log stats <from> <to>
+//   log undo                             log redo
+//   food add <id> <kw,kw,...> <calories> food calories <id> <calories>
+//   food show <id>                       search any|all <keyword>...
+//   query <expression>                   target
+//   save                                 help
+//
+// Blank lines and lines starting with '#' produce no output. The processor only holds
+// references, so it is cheap to create for each request.
+class CommandProcessor
+{
+public:
+    CommandProcessor(FoodDatabase &db, LogManager &logManager, DietGoalProfile &profile);
+
+    // Run one command line and append its response; false if the command failed
+    bool execute(std::string_view line, std::string &out);
+
+    // Whether any command changed data that has not been saved yet
+    bool hasUnsavedChanges() const;
+
+    // The command word of a line ("log", "search", ...), empty for blank lines
+    static std::string_view commandOf(std::string_view line);
+
+    // Whether a command only reads, so it may run alongside other read-only commands
+    static bool isReadOnly(std::string_view line);
+
+    // Save the foods, the logs and (if loaded) the profile as one group commit
+    bool save();
+
+private:
+    using Args = std::vector<std::string_view>;
+
+    bool runLog(const Args &args, std::string &out);
+    bool runFood(const Args &args, std::string &out);
+    bool runSearch(const Args &args, std::string &out);
+    bool runQuery(std::string_view expression, std::string &out);
+    bool runTarget(const Args &args, std::string &out);
+
+    // Append "error: <message>" and return false
+    static bool fail(std::string &out, std::string_view message);
+
+    FoodDatabase &m_db;
+    LogManager &m_logManager;
+    DietGoalProfile &m_profile;
+    bool m_unsaved = false;
+    Args m_args; // Tokens of the current line, kept to reuse the allocation
+};
+
+#endif // COMMAND_PROCESSOR_H
@@ -0,0 +1,112 @@
+#include "CalorieAggregator.h"
+#include <algorithm>
+#include <limits>
+
+CalorieAggregator::CalorieAggregator() : m_firstDay(0), m_capacity(0) {}
+
+CalorieAggregator::Node CalorieAggregator::emptyNode() {
+    return {0.0, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), 0};
+}
+
+CalorieAggregator::Node CalorieAggregator::combine(const Node &left, const Node &right) {
+    return {left.sum + right.sum, std::min(left.min, right.min), std::max(left.max, right.max),
+            left.count + right.count};
+}
+
+void CalorieAggregator::clear() {
+    m_firstDay = 0;
+    m_capacity = 0;
+    m_tree.clear();
+}
+
+void CalorieAggregator::cover(int dayNumber) {
+    if (m_capacity > 0 && dayNumber >= m_firstDay && dayNumber < m_firstDay + static_cast<int>(m_capacity)) {
+        return;
+    }
+
+    // Grow the window to a power of two that spans the old window and the new day
+    int firstDay = m_capacity > 0 ? std::min(m_firstDay, dayNumber) : dayNumber;
+    int lastDay = m_capacity > 0 ? std::max(m_firstDay + static_cast<int>(m_capacity) - 1, dayNumber) : dayNumber;
+    size_t capacity = std::max<size_t>(m_capacity, 64);
+    while (capacity < static_cast<size_t>(lastDay - firstDay + 1)) {
+        capacity *= 2;
+    }
+
+    std::vector<Node> tree(2 * capacity, emptyNode());
+    for (size_t i = 0; i < m_capacity; ++i) {
+        tree[capacity + (m_firstDay - firstDay) + i] = m_tree[m_capacity + i];
+    }
+    for (size_t i = capacity - 1; i > 0; --i) {
+        tree[i] = combine(tree[2 * i], tree[2 * i + 1]);
+    }
+
+    m_tree.swap(tree);
+    m_firstDay = firstDay;
+    m_capacity = capacity;
+}
+
+void CalorieAggregator::setLeaf(size_t leaf, const Node &node) {
+    size_t i = m_capacity + leaf;
+    m_tree[i] = node;
+    for (i /= 2; i > 0; i /= 2) {
+        m_tree[i] = combine(m_tree[2 * i], m_tree[2 * i + 1]);
+    }
+}
+
+void CalorieAggregator::setDayTotal(int dayNumber, double calories) {
+    cover(dayNumber);
+    setLeaf(dayNumber - m_firstDay, {calories, calories, calories, 1});
+}
+
+void CalorieAggregator::removeDay(int dayNumber) {
+    if (m_capacity == 0 || dayNumber < m_firstDay || dayNumber >= m_firstDay + static_cast<int>(m_capacity)) {
+        return;
+    }
+    setLeaf(dayNumber - m_firstDay, emptyNode());
+}
+
+bool CalorieAggregator::getDayTotal(int dayNumber, double& calories) const {
+    if (m_capacity == 0 || dayNumber < m_firstDay || dayNumber >= m_firstDay + static_cast<int>(m_capacity)) {
+        return false;
+    }
+    const Node& leaf = m_tree[m_capacity + (dayNumber - m_firstDay)];
+    if (leaf.count == 0) {
+        return false;
+    }
+    calories = leaf.sum;
+    return true;
+}
+
+CalorieSummary CalorieAggregator::query(int firstDay, int lastDay) const {
+    CalorieSummary summary;
+    if (m_capacity == 0) {
+        return summary;
+    }
+
+    // Clip the range to the window
+    firstDay = std::max(firstDay, m_firstDay);
+    lastDay = std::min(lastDay, m_firstDay + static_cast<int>(m_capacity) - 1);
+    if (firstDay > lastDay) {
+        return summary;
+    }
+
+    // Bottom-up query over the half-open leaf range [lo, hi)
+    Node result = emptyNode();
+    size_t lo = m_capacity + (firstDay - m_firstDay);
+    size_t hi = m_capacity + (lastDay - m_firstDay) + 1;
+    while (lo < hi) {
+        if (lo & 1) result = combine(result, m_tree[lo++]);
+        if (hi & 1) result = combine(result, m_tree[--hi]);
+        lo /= 2;
+        hi /= 2;
+    }
+
+    if (result.count > 0) {
+        summary.days = result.count;
+        summary.total = result.sum;
+        summary.average = result.sum / result.count;
+        summary.minimum = result.min;
+        summary.maximum = result.max;
+    }
+    return summary;
+}
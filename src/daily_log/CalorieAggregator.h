@@ -0,0 +1,61 @@
+#ifndef CALORIE_AGGREGATOR_H
+#define CALORIE_AGGREGATOR_H
+
+#include <cstddef>
+#include <vector>
+
+// Aggregate of consumed calories over the logged days in a date range
+struct CalorieSummary
+{
+    int days = 0;          // Logged days in the range
+    double total = 0.0;    // Sum of daily totals
+    double average = 0.0;  // Average daily total over logged days
+    double minimum = 0.0;  // Lowest daily total
+    double maximum = 0.0;  // Highest daily total
+};
+
+// Segment tree of per-day calorie totals keyed by day number.
+// The tree covers a window of days starting at m_firstDay and doubles whenever a day
+// outside the window is set, so updates and range queries are O(log days).
+class CalorieAggregator
+{
+public:
+    CalorieAggregator();
+
+    // Remove all days
+    void clear();
+
+    // Set the total calories of a logged day
+    void setDayTotal(int dayNumber, double calories);
+
+    // Mark a day as not logged
+    void removeDay(int dayNumber);
+
+    // Get the total of a logged day; false if the day is not logged
+    bool getDayTotal(int dayNumber, double &calories) const;
+
+    // Aggregate the logged days in [firstDay, lastDay]
+    CalorieSummary query(int firstDay, int lastDay) const;
+
+private:
+    struct Node
+    {
+        double sum;
+        double min;
+        double max;
+        int count;
+    };
+
+    static Node emptyNode();
+    static Node combine(const Node &left, const Node &right);
+
+    // Make sure dayNumber falls inside the window, rebuilding the tree if needed
+    void cover(int dayNumber);
+    void setLeaf(size_t leaf, const Node &node);
+
+    int m_firstDay;          // Day number of the first leaf
+    size_t m_capacity;       // Number of leaves (power of two)
+    std::vector<Node> m_tree; // Implicit tree, leaves at [m_capacity, 2 * m_capacity)
+};
+
+#endif // CALORIE_AGGREGATOR_H
@@ -1,39 +1,79 @@
 #include "DailyLog.h"
+#include "food/FoodDispatch.h"
+#include "utils/DateUtils.h"
+#include "utils/FileHandler.h"
+#include "utils/Metrics.h"
+#include "utils/MemoryAccounting.h"
+#include "utils/Tracer.h"
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <ctime>
 #include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+// The journal's ring buffer is allocated up front; charge it to the undo history
+UndoJournal<LogManager::UndoItem> makeJournal(size_t capacity) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::UNDO_JOURNAL);
+    return UndoJournal<LogManager::UndoItem>(capacity);
+}
+
+} // namespace
 
 // DailyLogEntry Implementation
-DailyLogEntry::DailyLogEntry(std::shared_ptr<Food> food, double servings)
-    : m_food(food), m_servings(servings) {}
+DailyLogEntry::DailyLogEntry(EntryId id, std::shared_ptr<Food> food, double servings)
+    : m_id(id), m_food(food), m_servings(servings) {}
 
+EntryId DailyLogEntry::getId() const { return m_id; }
 std::shared_ptr<Food> DailyLogEntry::getFood() const { return m_food; }
 double DailyLogEntry::getServings() const { return m_servings; }
-double DailyLogEntry::getTotalCalories() const { return m_food->getCaloriesPerServing() * m_servings; }
+double DailyLogEntry::getTotalCalories() const { return caloriesOf(*m_food) * m_servings; }
 
 // DailyLog Implementation
-void DailyLog::addFoodEntry(std::shared_ptr<Food> food, double servings) {
-    m_foodEntries.emplace_back(food, servings);
+DailyLog::DailyLog() : m_nextId(0) {}
+
+EntryId DailyLog::addFoodEntry(std::shared_ptr<Food> food, double servings) {
+    EntryId id = m_nextId++;
+    m_foodEntries.emplace_hint(m_foodEntries.end(), id, DailyLogEntry(id, food, servings));
+    return id;
 }
 
 bool DailyLog::removeFoodEntry(size_t index) {
-    if (index >= m_foodEntries.size()) {
+    const DailyLogEntry* entry = getFoodEntryAt(index);
+    return entry && removeFoodEntryById(entry->getId());
+}
+
+bool DailyLog::removeFoodEntryById(EntryId id) {
+    return m_foodEntries.erase(id) > 0;
+}
+
+bool DailyLog::restoreFoodEntry(EntryId id, std::shared_ptr<Food> food, double servings) {
+    if (id >= m_nextId) {
         return false;
     }
-    m_foodEntries.erase(m_foodEntries.begin() + index);
-    return true;
+    return m_foodEntries.emplace(id, DailyLogEntry(id, food, servings)).second;
 }
 
-const std::vector<DailyLogEntry>& DailyLog::getFoodEntries() const {
+const DailyLogEntry* DailyLog::getFoodEntryAt(size_t index) const {
+    if (index >= m_foodEntries.size()) {
+        return nullptr;
+    }
+    return &std::next(m_foodEntries.begin(), index)->second;
+}
+
+const std::map<EntryId, DailyLogEntry>& DailyLog::getFoodEntries() const {
     return m_foodEntries;
 }
 
 double DailyLog::getTotalCalories() const {
     double total = 0.0;
-    for (const auto& entry : m_foodEntries) {
+    for (const auto& [id, entry] : m_foodEntries) {
         total += entry.getTotalCalories();
     }
     return total;
@@ -43,20 +83,9 @@ void DailyLog::clearEntries() {
     m_foodEntries.clear();
 }
 
-void DailyLog::insertFoodEntry(std::shared_ptr<Food> food, double servings, size_t index) {
-    // Create the log entry
-    DailyLogEntry entry(food, servings);
-    
-    // If index is valid, insert at position, otherwise append
-    if (index < m_foodEntries.size()) {
-        m_foodEntries.insert(m_foodEntries.begin() + index, entry);
-    } else {
-        m_foodEntries.push_back(entry);
-    }
-}
-
 // LogManager Implementation
-LogManager::LogManager(const std::string& logFilePath) : m_logFilePath(logFilePath) {
+LogManager::LogManager(const std::string& logFilePath, size_t undoCapacity)
+    : m_logFilePath(logFilePath), m_journal(makeJournal(undoCapacity)) {
     std::ofstream file(m_logFilePath, std::ios::app);
     if (!file.is_open()) {
         std::cerr << "Warning: Could not create or access log file at " << m_logFilePath << std::endl;
@@ -68,155 +97,411 @@ LogManager::LogManager(const std::string& logFilePath) : m_logFilePath(logFilePa
 
 
 bool LogManager::isValidDateFormat(const std::string& date) {
-    // Check length (DD-MM-YYYY = 10 chars)
-    if (date.length() != 10) return false;
-    
-    // Check for hyphens at positions 2 and 5
-    if (date[2] != '-' || date[5] != '-') return false;
-    
-    try {
-        // Check that all other positions are digits
-        for (int i = 0; i < 10; i++) {
-            if (i != 2 && i != 5 && !std::isdigit(date[i]))
-                return false;
-        }
-        
-        // Extract day, month, and year
-        int day = std::stoi(date.substr(0, 2));
-        int month = std::stoi(date.substr(3, 2));
-        int year = std::stoi(date.substr(6, 4));
-        
-        // Basic validation for year, month, and day
-        if (year < 2000 || year > 2100) return false;
-        if (month < 1 || month > 12) return false;
-        if (day < 1 || day > 31) return false;
-        
-        // Check days in month (simplified, doesn't account for leap years)
-        if (month == 2 && day > 29) return false;
-        if ((month == 4 || month == 6 || month == 9 || month == 11) && day > 30) return false;
-        
-        return true;
-    }
-    catch (...) {
+    // Same calendar as the day numbers the totals, archive and analytics use, so every path
+    // agrees on which dates exist (29-02 only in leap years)
+    int dayNumber;
+    if (!DateUtils::toDayNumber(date, dayNumber)) {
         return false;
     }
+
+    // Well-formed from here on; logs only cover 2000-2100
+    int year = std::atoi(date.c_str() + 6);
+    return year >= 2000 && year <= 2100;
 }
 
 bool LogManager::loadLogs(FoodDatabase& foodDatabase) {
-    std::ifstream file(m_logFilePath);
+    TRACE_SCOPE("LogManager::loadLogs");
+    Metrics::Timer timer(Metrics::Id::LOG_LOAD);
+    MemoryAccounting::Scope memoryScope(MemoryTag::LOGS);
+    // The archive holds older days; load it even if the text log is missing
+    m_archive.load(getArchivePath(), foodDatabase);
+    m_archivedDays.clear();
+
+    std::ifstream file(m_logFilePath, std::ios::binary);
     if (!file.is_open()) {
         return false;
     }
 
+    // Read the whole file once; lines and food IDs below are views into this buffer
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    struct PendingEntry {
+        size_t block; // Index into blocks
+        std::string_view foodId;
+        double servings;
+    };
+    struct DateBlock {
+        DailyLog* log;
+        bool superseded; // A later header for the same date starts the day over
+    };
+    std::vector<DateBlock> blocks;
+    std::unordered_map<std::string, size_t> latestBlock; // Date to its most recent block
+    std::vector<PendingEntry> pending;
+    std::unordered_map<std::string_view, std::shared_ptr<Food>> resolved; // Per-load memo of food IDs
+
     m_logs.clear();
-    std::string line;
+    m_journal.clear(); // Journaled entry IDs refer to the logs being replaced
     std::string currentDate;
 
-    while (std::getline(file, line)) {
+    size_t lineStart = 0;
+    while (lineStart < contents.size()) {
+        size_t lineEnd = contents.find('\n', lineStart);
+        if (lineEnd == std::string::npos) {
+            lineEnd = contents.size();
+        }
+        std::string_view line(contents.data() + lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
         if (line.substr(0, 6) == "DATE: ") {
-            currentDate = line.substr(6);
+            currentDate = std::string(line.substr(6));
             
             // Validate date format before adding to logs
             if (isValidDateFormat(currentDate)) {
-                m_logs[currentDate] = DailyLog();
+                auto previous = latestBlock.find(currentDate);
+                if (previous != latestBlock.end()) {
+                    blocks[previous->second].superseded = true;
+                }
+                latestBlock[currentDate] = blocks.size();
+                blocks.push_back({&m_logs[currentDate], false});
             } else {
                 std::cerr << "Warning: Invalid date format found in log file: " << currentDate << std::endl;
                 currentDate = ""; // Reset current date to avoid adding entries to an invalid date
             }
         } else if (!currentDate.empty() && !line.empty()) {
-            std::istringstream iss(line);
-            std::string foodId;
-            double servings;
-
-            if (std::getline(iss, foodId, ',') && iss >> servings) {
-                auto food = foodDatabase.getFoodById(foodId);
-                if (food) {
-                    m_logs[currentDate].addFoodEntry(food, servings);
-                } else {
-                    std::cerr << "Warning: Food ID '" << foodId << "' not found in database." << std::endl;
-                }
+            size_t comma = line.find(',');
+            if (comma == std::string_view::npos) {
+                continue;
             }
+
+            const char* servingsStart = line.data() + comma + 1;
+            char* servingsEnd = nullptr;
+            double servings = std::strtod(servingsStart, &servingsEnd);
+            if (servingsEnd == servingsStart || servingsEnd > line.data() + line.size()) {
+                continue;
+            }
+
+            std::string_view foodId = line.substr(0, comma);
+            pending.push_back({blocks.size() - 1, foodId, servings});
+            resolved.emplace(foodId, nullptr);
         }
     }
 
+    // Resolve every distinct food ID in one batch instead of one lookup per line
+    std::vector<std::string_view> ids;
+    ids.reserve(resolved.size());
+    for (const auto& pair : resolved) {
+        ids.push_back(pair.first);
+    }
+    auto foods = foodDatabase.getFoodsByIds(ids);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        resolved[ids[i]] = foods[i];
+    }
+
+    for (const auto& entry : pending) {
+        const DateBlock& block = blocks[entry.block];
+        if (block.superseded) {
+            continue;
+        }
+        const auto& food = resolved[entry.foodId];
+        if (food) {
+            block.log->addFoodEntry(food, entry.servings);
+        } else {
+            std::cerr << "Warning: Food ID '" << entry.foodId << "' not found in database." << std::endl;
+        }
+    }
+
+    rebuildCalorieTotals();
     return true;
 }
 
 bool LogManager::saveLogs() {
-    std::ofstream file(m_logFilePath);
-    if (!file.is_open()) {
-        return false;
-    }
+    TRACE_SCOPE("LogManager::saveLogs");
+    return FileHandler::writeFileAtomically(m_logFilePath, serializeLogs());
+}
+
+const std::string& LogManager::getLogFilePath() const {
+    return m_logFilePath;
+}
 
+std::string LogManager::serializeLogs() const {
+    TRACE_SCOPE("LogManager::serializeLogs");
+    Metrics::Timer timer(Metrics::Id::LOG_SERIALIZE);
+    MemoryAccounting::Scope memoryScope(MemoryTag::LOGS);
+    std::ostringstream file;
     for (const auto& [date, log] : m_logs) {
         file << "DATE: " << date << std::endl;
-        for (const auto& entry : log.getFoodEntries()) {
+        for (const auto& [id, entry] : log.getFoodEntries()) {
             file << entry.getFood()->getId() << "," 
                  << entry.getServings() << std::endl;
         }
         file << std::endl;  // Separate different dates
     }
 
-    return true;
+    return file.str();
 }
 
 DailyLog& LogManager::getLog(const std::string& date) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::LOGS);
     if (!isValidDateFormat(date)) {
         std::cerr << "Invalid date format. Please use DD-MM-YYYY." << std::endl;
         // what to return when there is an error - fix later....
     }
-    else
-    return m_logs[date];
+    else {
+        if (m_logs.count(date) == 0) {
+            auto archived = m_archivedDays.find(date);
+            if (archived != m_archivedDays.end()) {
+                return archived->second;
+            }
+            DailyLog log;
+            if (readArchivedDay(date, log)) {
+                return m_archivedDays.emplace(date, std::move(log)).first->second;
+            }
+        }
+        return m_logs[date];
+    }
+}
 
+std::string LogManager::getArchivePath() const {
+    return LogArchive::pathFor(m_logFilePath);
 }
 
+bool LogManager::readArchivedDay(const std::string& date, DailyLog& log) const {
+    int dayNumber;
+    std::vector<std::pair<std::shared_ptr<Food>, double>> entries;
+    if (!DateUtils::toDayNumber(date, dayNumber) || !m_archive.readDay(dayNumber, entries)) {
+        return false;
+    }
+    for (const auto& [food, servings] : entries) {
+        log.addFoodEntry(food, servings);
+    }
+    return true;
+}
 
+DailyLog* LogManager::findEditableLog(const std::string& date) {
+    auto it = m_logs.find(date);
+    if (it != m_logs.end()) {
+        return &it->second;
+    }
 
-void LogManager::addUndoAction(LogAction action, const std::string& date, 
-                             std::shared_ptr<Food> food, double servings, size_t index) {
-    UndoItem item = {action, date, food, servings, index};
-    m_undoStack.push_back(item);
+    // Editing an archived day brings it back into the text log, which takes precedence
+    DailyLog log;
+    if (!readArchivedDay(date, log)) {
+        return nullptr;
+    }
+    m_archivedDays.erase(date);
+    return &m_logs.emplace(date, std::move(log)).first->second;
 }
 
+bool LogManager::archiveDaysBefore(const std::string& cutoffDate, FoodDatabase& db, size_t& archivedDays) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::LOGS);
+    int cutoff;
+    if (!DateUtils::toDayNumber(cutoffDate, cutoff)) {
+        return false;
+    }
 
-void LogManager::undo() {
-    if (m_undoStack.empty()) {
-        std::cout << "Nothing to undo." << std::endl;
+    // Empty days are archived too, so they keep hiding older archived copies of the same date
+    std::map<int, LogArchive::DayEntries> days;
+    std::vector<std::string> dates;
+    for (const auto& [date, log] : m_logs) {
+        int dayNumber;
+        if (!DateUtils::toDayNumber(date, dayNumber) || dayNumber >= cutoff) {
+            continue;
+        }
+        LogArchive::DayEntries& entries = days[dayNumber];
+        for (const auto& [id, entry] : log.getFoodEntries()) {
+            entries.emplace_back(entry.getFood()->getId(), entry.getServings());
+        }
+        dates.push_back(date);
+    }
+
+    // The archive and the shortened text log are committed together. The days leave memory
+    // only once both are on disk, so a failed commit can't lead a later save to drop them; the
+    // archive is written first, so if only it was replaced the text copy still takes precedence
+    FileHandler::GroupCommit group;
+    LogArchive previousArchive = m_archive;
+    if (!days.empty() && !m_archive.merge(days, getArchivePath(), db)) {
+        m_archive = std::move(previousArchive);
+        return false;
+    }
+    std::map<std::string, DailyLog> moved;
+    for (const auto& date : dates) {
+        moved.insert(m_logs.extract(date));
+    }
+    if (!saveLogs() || !group.commit()) {
+        m_logs.merge(moved);
+        m_archive = std::move(previousArchive);
+        return false;
+    }
+    m_archivedDays.clear();
+    m_journal.clear(); // Journaled entry IDs refer to days that are no longer in the text log
+    archivedDays = days.size();
+    return true;
+}
+
+bool LogManager::addFoodEntry(const std::string& date, std::shared_ptr<Food> food, double servings) {
+    Metrics::Timer timer(Metrics::Id::LOG_ADD);
+    MemoryAccounting::Scope memoryScope(MemoryTag::LOGS);
+    if (!food || !isValidDateFormat(date)) {
+        return false;
+    }
+
+    auto existing = m_logs.find(date);
+    DailyLog* log = existing != m_logs.end() ? &existing->second : findEditableLog(date);
+    DailyLog& day = log ? *log : m_logs[date];
+    EntryId id = day.addFoodEntry(food, servings);
+    addUndoAction(LogAction::ADD, date, id, food, servings);
+
+    // The new entry sorts last, so adding it to the known total sums in the same order as
+    // DailyLog::getTotalCalories and gives the identical result without rescanning the day
+    int dayNumber;
+    double total = 0.0;
+    if (existing != m_logs.end() && DateUtils::toDayNumber(date, dayNumber)) {
+        m_calorieTotals.getDayTotal(dayNumber, total);
+        m_calorieTotals.setDayTotal(dayNumber, total + day.getFoodEntries().rbegin()->second.getTotalCalories());
+    } else {
+        refreshDayTotal(date);
+    }
+    return true;
+}
+
+bool LogManager::removeFoodEntry(const std::string& date, size_t index) {
+    Metrics::Timer timer(Metrics::Id::LOG_REMOVE);
+    MemoryAccounting::Scope memoryScope(MemoryTag::LOGS);
+    DailyLog* log = findEditableLog(date);
+    if (!log) {
+        return false;
+    }
+    const DailyLogEntry* entry = log->getFoodEntryAt(index);
+    if (!entry) {
+        return false;
+    }
+
+    EntryId id = entry->getId();
+    addUndoAction(LogAction::REMOVE, date, id, entry->getFood(), entry->getServings());
+    log->removeFoodEntryById(id);
+    refreshDayTotal(date);
+    return true;
+}
+
+void LogManager::refreshDayTotal(const std::string& date) {
+    int dayNumber;
+    if (!DateUtils::toDayNumber(date, dayNumber)) {
         return;
     }
-    
-    UndoItem item = m_undoStack.back();
-    m_undoStack.pop_back();
-    
-    try {
-        DailyLog& log = m_logs[item.date];
-        
-        switch (item.action) {
-            case LogAction::ADD:
-                // If the last action was ADD, we need to remove the food
-                if (!log.getFoodEntries().empty()) {
-                    log.removeFoodEntry(log.getFoodEntries().size() - 1);
-                    std::cout << "Undid addition of " << item.food->getName() << std::endl;
-                }
-                break;
-                
-            case LogAction::REMOVE:
-                // If the last action was REMOVE, we need to add the food back at its original position
-                if (item.index < log.getFoodEntries().size()) {
-                    // We need to implement an insertFoodEntry method in DailyLog
-                    log.insertFoodEntry(item.food, item.servings, item.index);
-                } else {
-                    // If the original position is now beyond the end of the list, just append
-                    log.addFoodEntry(item.food, item.servings);
-                }
-                std::cout << "Restored " << item.food->getName() << " to log" << std::endl;
-                break;
+
+    double archivedCalories;
+    auto it = m_logs.find(date);
+    if (it != m_logs.end() && !it->second.getFoodEntries().empty()) {
+        m_calorieTotals.setDayTotal(dayNumber, it->second.getTotalCalories());
+    } else if (it == m_logs.end() && m_archive.dayTotal(dayNumber, archivedCalories)) {
+        m_calorieTotals.setDayTotal(dayNumber, archivedCalories);
+    } else {
+        m_calorieTotals.removeDay(dayNumber);
+    }
+}
+
+void LogManager::rebuildCalorieTotals() {
+    TRACE_SCOPE("LogManager::rebuildCalorieTotals");
+    MemoryAccounting::Scope memoryScope(MemoryTag::LOGS);
+    m_calorieTotals.clear();
+    m_archive.forEachDayTotal([this](int dayNumber, double calories) {
+        if (m_logs.count(DateUtils::fromDayNumber(dayNumber)) == 0) {
+            m_calorieTotals.setDayTotal(dayNumber, calories);
+        }
+    });
+    for (const auto& [date, log] : m_logs) {
+        int dayNumber;
+        if (!log.getFoodEntries().empty() && DateUtils::toDayNumber(date, dayNumber)) {
+            m_calorieTotals.setDayTotal(dayNumber, log.getTotalCalories());
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Error during undo: " << e.what() << std::endl;
     }
 }
 
+size_t LogManager::estimateMemoryUsage() const {
+    // Tree nodes carry roughly four pointers of overhead on top of their value
+    const size_t nodeOverhead = 4 * sizeof(void*);
+    size_t bytes = sizeof(LogManager) + m_logFilePath.capacity();
+    for (const auto& [date, log] : m_logs) {
+        bytes += nodeOverhead + sizeof(std::pair<const std::string, DailyLog>) + date.capacity();
+        bytes += log.getFoodEntries().size() * (nodeOverhead + sizeof(std::pair<const EntryId, DailyLogEntry>));
+    }
+    bytes += m_journal.capacity() * sizeof(UndoItem);
+    return bytes;
+}
+
+bool LogManager::getCalorieSummary(const std::string& fromDate, const std::string& toDate,
+                                   CalorieSummary& summary) const {
+    int firstDay, lastDay;
+    if (!DateUtils::toDayNumber(fromDate, firstDay) || !DateUtils::toDayNumber(toDate, lastDay)) {
+        return false;
+    }
+
+    summary = m_calorieTotals.query(firstDay, lastDay);
+    return true;
+}
+
+void LogManager::addUndoAction(LogAction action, const std::string& date, EntryId entryId,
+                               std::shared_ptr<Food> food, double servings) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::UNDO_JOURNAL);
+    m_journal.record({action, date, entryId, food, servings});
+}
+
+bool LogManager::applyJournalItem(const UndoItem& item, bool addEntry) {
+    auto it = m_logs.find(item.date);
+    if (it == m_logs.end()) {
+        return false;
+    }
+    bool applied = addEntry ? it->second.restoreFoodEntry(item.entryId, item.food, item.servings)
+                            : it->second.removeFoodEntryById(item.entryId);
+    refreshDayTotal(item.date);
+    return applied;
+}
+
+bool LogManager::undo(std::string& message) {
+    Metrics::Timer timer(Metrics::Id::LOG_UNDO);
+    MemoryAccounting::Scope memoryScope(MemoryTag::LOGS);
+    UndoItem item;
+    if (!m_journal.popUndo(item)) {
+        message = "Nothing to undo.";
+        return false;
+    }
+
+    // Apply the exact inverse: an added entry is removed by ID, a removed one returns under its ID
+    bool addEntry = item.action == LogAction::REMOVE;
+    if (!applyJournalItem(item, addEntry)) {
+        message = "Error during undo: entry no longer matches the log.";
+        return false;
+    }
+    if (addEntry) {
+        message = "Restored " + item.food->getName() + " to log";
+    } else {
+        message = "Undid addition of " + item.food->getName();
+    }
+    return true;
+}
+
+bool LogManager::redo(std::string& message) {
+    Metrics::Timer timer(Metrics::Id::LOG_REDO);
+    MemoryAccounting::Scope memoryScope(MemoryTag::LOGS);
+    UndoItem item;
+    if (!m_journal.popRedo(item)) {
+        message = "Nothing to redo.";
+        return false;
+    }
+
+    bool addEntry = item.action == LogAction::ADD;
+    if (!applyJournalItem(item, addEntry)) {
+        message = "Error during redo: entry no longer matches the log.";
+        return false;
+    }
+    if (addEntry) {
+        message = "Redid addition of " + item.food->getName();
+    } else {
+        message = "Removed " + item.food->getName() + " from log again";
+    }
+    return true;
+}
+
 
 std::string LogManager::getCurrentDateString() {
     std::time_t now = std::time(nullptr);
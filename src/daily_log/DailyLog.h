@@ -7,19 +7,28 @@
 #include <map>
 #include <ctime>
 #include <functional>
+#include <cstdint>
 #include "food/Food.h"
 #include "database/FoodDatabase.h"
+#include "CalorieAggregator.h"
+#include "UndoJournal.h"
+#include "LogArchive.h"
+
+// Identifies an entry within its day; IDs only grow, so ID order is insertion order
+using EntryId = std::uint64_t;
 
 class DailyLogEntry
 {
 public:
-    DailyLogEntry(std::shared_ptr<Food> food, double servings);
+    DailyLogEntry(EntryId id, std::shared_ptr<Food> food, double servings);
 
+    EntryId getId() const;
     std::shared_ptr<Food> getFood() const;
     double getServings() const;
     double getTotalCalories() const;
 
 private:
+    EntryId m_id;
     std::shared_ptr<Food> m_food;
     double m_servings;
 };
@@ -27,14 +36,25 @@ private:
 class DailyLog
 {
 public:
-    // Add food to the log
-    void addFoodEntry(std::shared_ptr<Food> food, double servings);
+    DailyLog();
+
+    // Add food to the log and return the new entry's ID
+    EntryId addFoodEntry(std::shared_ptr<Food> food, double servings);
 
-    // Remove a specific food entry
+    // Remove the entry at a position in the day (O(n) to find it)
     bool removeFoodEntry(size_t index);
 
-    // Get all food entries for the day
-    const std::vector<DailyLogEntry> &getFoodEntries() const;
+    // Remove the entry with the given ID in O(log n)
+    bool removeFoodEntryById(EntryId id);
+
+    // Put back a removed entry under its original ID, and so at its original position
+    bool restoreFoodEntry(EntryId id, std::shared_ptr<Food> food, double servings);
+
+    // Find the entry at a position in the day
+    const DailyLogEntry *getFoodEntryAt(size_t index) const;
+
+    // Get all food entries for the day, in the order they were logged
+    const std::map<EntryId, DailyLogEntry> &getFoodEntries() const;
 
     // Calculate total calories for the day
     double getTotalCalories() const;
@@ -42,13 +62,9 @@ public:
     // Clear all entries for the day
     void clearEntries();
 
-    // Insert a food entry at a specific position
-    void insertFoodEntry(std::shared_ptr<Food> food, double servings, size_t index);
-
-    
-
 private:
-    std::vector<DailyLogEntry> m_foodEntries;
+    std::map<EntryId, DailyLogEntry> m_foodEntries;
+    EntryId m_nextId; // Never reused, even after entries are removed
 };
 
 class LogManager
@@ -64,11 +80,11 @@ public:
     {
         LogAction action;
         std::string date;
+        EntryId entryId; // Entry added or removed
         std::shared_ptr<Food> food;
         double servings;
-        size_t index; // Only used for REMOVE actions
     };
-    LogManager(const std::string &logFilePath);
+    LogManager(const std::string &logFilePath, size_t undoCapacity = 256);
 
     // Load logs from file
     bool loadLogs(FoodDatabase &db);
@@ -76,20 +92,67 @@ public:
     // Save logs to file
     bool saveLogs();
 
-    // Get log for a specific date
+    // Render the text log without writing it
+    std::string serializeLogs() const;
+
+    const std::string &getLogFilePath() const;
+
+    // Get log for a specific date; archived days are decoded on demand and are read-only
     DailyLog &getLog(const std::string &date);
 
+    // Move every day before cutoffDate from the text log into the binary archive
+    bool archiveDaysBefore(const std::string &cutoffDate, FoodDatabase &db, size_t &archivedDays);
+
+    // Path of the binary archive next to the text log
+    std::string getArchivePath() const;
+
     // Check if a date string is in the correct format (DD-MM-YYYY)
     bool isValidDateFormat(const std::string &date);
     
-    void addUndoAction(LogAction action, const std::string& date, 
-                  std::shared_ptr<Food> food, double servings, size_t index = 0);
-    void undo();
+    // Add a food entry to a day and record it for undo
+    bool addFoodEntry(const std::string &date, std::shared_ptr<Food> food, double servings);
+
+    // Remove the entry at index from a day and record it for undo
+    bool removeFoodEntry(const std::string &date, size_t index);
+
+    void addUndoAction(LogAction action, const std::string &date, EntryId entryId,
+                       std::shared_ptr<Food> food, double servings);
+
+    // Revert the most recent action; false if there is nothing to undo.
+    // message describes what happened, for the caller to show
+    bool undo(std::string &message);
+
+    // Reapply the most recently undone action; false if there is nothing to redo
+    bool redo(std::string &message);
+
+    // Aggregate consumed calories over the logged days in [fromDate, toDate] in O(log days)
+    bool getCalorieSummary(const std::string &fromDate, const std::string &toDate, CalorieSummary &summary) const;
+
+    // Recompute every day's total, e.g. after foods were re-priced
+    void rebuildCalorieTotals();
+
+    // Rough number of bytes held by the loaded logs, for memory budgets
+    size_t estimateMemoryUsage() const;
 
 private:
     std::map<std::string, DailyLog> m_logs;
     std::string m_logFilePath;
-    std::vector<UndoItem> m_undoStack;
+    LogArchive m_archive;                            // Older days; the text log wins for dates in both
+    std::map<std::string, DailyLog> m_archivedDays;  // Archived days decoded by getLog
+    UndoJournal<UndoItem> m_journal; // Bounded undo/redo history
+    CalorieAggregator m_calorieTotals; // Per-day totals for range queries
+
+    // Add (addEntry) or remove the journaled entry of an undo item
+    bool applyJournalItem(const UndoItem &item, bool addEntry);
+
+    // Decode an archived day into a DailyLog
+    bool readArchivedDay(const std::string &date, DailyLog &log) const;
+
+    // Find a day's text log, moving it out of the archive if it only exists there
+    DailyLog *findEditableLog(const std::string &date);
+
+    // Push a day's current total into the aggregator
+    void refreshDayTotal(const std::string &date);
 
     // Helper to get current date string
     static std::string getCurrentDateString();
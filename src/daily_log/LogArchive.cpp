@@ -0,0 +1,344 @@
+#include "LogArchive.h"
+#include "food/FoodDispatch.h"
+#include "utils/FileHandler.h"
+#include "utils/Tracer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_map>
+
+namespace {
+
+const char MAGIC[] = "YADAARC1";
+const size_t MAGIC_LENGTH = 8;
+const size_t MAX_DICTIONARY = 127; // Codes 1..127 fit in one varint byte
+
+void putVarint(std::string &out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(const std::string &in, size_t &offset, std::uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= in.size()) {
+            return false;
+        }
+        unsigned char byte = static_cast<unsigned char>(in[offset++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void putDouble(std::string &out, double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+    }
+}
+
+bool getDouble(const std::string &in, size_t &offset, double &value) {
+    if (offset > in.size() || in.size() - offset < 8) {
+        return false;
+    }
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+        bits |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[offset + i])) << (8 * i);
+    }
+    offset += 8;
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+// Rank values by how often they occur, most frequent first
+template <typename T>
+std::vector<T> byFrequency(const std::map<T, size_t> &counts) {
+    std::vector<std::pair<size_t, T>> ranked;
+    for (const auto &[value, count] : counts) {
+        ranked.emplace_back(count, value);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const auto &a, const auto &b) { return a.first > b.first; });
+    std::vector<T> values;
+    for (const auto &pair : ranked) {
+        values.push_back(pair.second);
+    }
+    return values;
+}
+
+} // namespace
+
+LogArchive::LogArchive() : m_damaged(false) {}
+
+void LogArchive::clear() {
+    m_foodIds.clear();
+    m_foods.clear();
+    m_servingsDictionary.clear();
+    m_data.clear();
+    m_days.clear();
+    m_damaged = false;
+}
+
+std::string LogArchive::pathFor(const std::string &logFilePath) {
+    const std::string extension = ".txt";
+    if (logFilePath.size() > extension.size() &&
+        logFilePath.compare(logFilePath.size() - extension.size(), extension.size(), extension) == 0) {
+        return logFilePath.substr(0, logFilePath.size() - extension.size()) + ".archive";
+    }
+    return logFilePath + ".archive";
+}
+
+bool LogArchive::load(const std::string &path, const FoodDatabase &db) {
+    TRACE_SCOPE("LogArchive::load");
+    clear();
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!parse(std::move(data), db)) {
+        std::cerr << "Warning: Log archive " << path << " is damaged and was not loaded." << std::endl;
+        clear();
+        m_damaged = true;
+        return false;
+    }
+    return true;
+}
+
+bool LogArchive::parse(std::string data, const FoodDatabase &db) {
+    m_data = std::move(data);
+    if (m_data.size() < MAGIC_LENGTH || m_data.compare(0, MAGIC_LENGTH, MAGIC) != 0) {
+        return false;
+    }
+    size_t offset = MAGIC_LENGTH;
+    std::uint64_t count;
+
+    // Food table, resolved against the database in one batch
+    if (!getVarint(m_data, offset, count) || count > m_data.size()) {
+        return false;
+    }
+    for (std::uint64_t i = 0; i < count; ++i) {
+        std::uint64_t length;
+        if (!getVarint(m_data, offset, length) || length > m_data.size() - offset) {
+            return false;
+        }
+        m_foodIds.push_back(m_data.substr(offset, length));
+        offset += length;
+    }
+    std::vector<std::string_view> ids(m_foodIds.begin(), m_foodIds.end());
+    m_foods = db.getFoodsByIds(ids);
+
+    // Servings dictionary
+    if (!getVarint(m_data, offset, count) || count > MAX_DICTIONARY) {
+        return false;
+    }
+    for (std::uint64_t i = 0; i < count; ++i) {
+        double value;
+        if (!getDouble(m_data, offset, value)) {
+            return false;
+        }
+        m_servingsDictionary.push_back(value);
+    }
+
+    // Day index: remember where each day's entries start, validating them on the way
+    if (!getVarint(m_data, offset, count) || count > m_data.size()) {
+        return false;
+    }
+    std::int64_t dayNumber = 0;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        std::uint64_t delta, entries;
+        if (!getVarint(m_data, offset, delta) || !getVarint(m_data, offset, entries) || entries > m_data.size()) {
+            return false;
+        }
+        dayNumber += unzigzag(delta);
+        m_days[static_cast<int>(dayNumber)] = {offset, static_cast<size_t>(entries)};
+
+        for (std::uint64_t e = 0; e < entries; ++e) {
+            size_t foodIndex;
+            double servings;
+            if (!decodeEntry(offset, foodIndex, servings)) {
+                return false;
+            }
+        }
+    }
+    return offset == m_data.size();
+}
+
+bool LogArchive::decodeEntry(size_t &offset, size_t &foodIndex, double &servings) const {
+    std::uint64_t food, code;
+    if (!getVarint(m_data, offset, food) || food >= m_foodIds.size() || !getVarint(m_data, offset, code)) {
+        return false;
+    }
+    foodIndex = static_cast<size_t>(food);
+    if (code == 0) {
+        return getDouble(m_data, offset, servings);
+    }
+    if (code > m_servingsDictionary.size()) {
+        return false;
+    }
+    servings = m_servingsDictionary[code - 1];
+    return true;
+}
+
+bool LogArchive::merge(const std::map<int, DayEntries> &days, const std::string &path, const FoodDatabase &db) {
+    TRACE_SCOPE("LogArchive::merge");
+    if (m_damaged) {
+        std::cerr << "Error: Refusing to overwrite damaged log archive " << path << std::endl;
+        return false;
+    }
+
+    // Decode what is already archived, then let the new days replace or extend it
+    std::map<int, DayEntries> allDays;
+    for (const auto &[dayNumber, ref] : m_days) {
+        DayEntries &entries = allDays[dayNumber];
+        size_t offset = ref.offset;
+        for (size_t e = 0; e < ref.entries; ++e) {
+            size_t foodIndex;
+            double servings;
+            decodeEntry(offset, foodIndex, servings);
+            entries.emplace_back(m_foodIds[foodIndex], servings);
+        }
+    }
+    for (const auto &[dayNumber, entries] : days) {
+        allDays[dayNumber] = entries;
+    }
+
+    // Frequent foods and servings get the shortest codes
+    std::map<std::string, size_t> foodCounts;
+    std::map<double, size_t> servingsCounts;
+    for (const auto &[dayNumber, entries] : allDays) {
+        for (const auto &[foodId, servings] : entries) {
+            ++foodCounts[foodId];
+            ++servingsCounts[servings];
+        }
+    }
+    std::vector<std::string> foodIds = byFrequency(foodCounts);
+    std::unordered_map<std::string, size_t> foodIndex;
+    for (size_t i = 0; i < foodIds.size(); ++i) {
+        foodIndex[foodIds[i]] = i;
+    }
+    std::vector<double> dictionary;
+    for (double value : byFrequency(servingsCounts)) {
+        if (dictionary.size() == MAX_DICTIONARY || servingsCounts[value] < 2) {
+            break;
+        }
+        dictionary.push_back(value);
+    }
+    std::map<double, size_t> servingsCode;
+    for (size_t i = 0; i < dictionary.size(); ++i) {
+        servingsCode[dictionary[i]] = i + 1;
+    }
+
+    std::string out(MAGIC, MAGIC_LENGTH);
+    putVarint(out, foodIds.size());
+    for (const auto &id : foodIds) {
+        putVarint(out, id.size());
+        out += id;
+    }
+    putVarint(out, dictionary.size());
+    for (double value : dictionary) {
+        putDouble(out, value);
+    }
+    putVarint(out, allDays.size());
+    std::int64_t previousDay = 0;
+    for (const auto &[dayNumber, entries] : allDays) {
+        putVarint(out, zigzag(dayNumber - previousDay));
+        previousDay = dayNumber;
+        putVarint(out, entries.size());
+        for (const auto &[foodId, servings] : entries) {
+            putVarint(out, foodIndex[foodId]);
+            auto code = servingsCode.find(servings);
+            if (code != servingsCode.end()) {
+                putVarint(out, code->second);
+            } else {
+                putVarint(out, 0);
+                putDouble(out, servings);
+            }
+        }
+    }
+
+    if (!FileHandler::writeFileAtomically(path, out)) {
+        std::cerr << "Error: Could not write log archive " << path << std::endl;
+        return false;
+    }
+
+    clear();
+    return parse(std::move(out), db);
+}
+
+bool LogArchive::contains(int dayNumber) const {
+    return m_days.count(dayNumber) > 0;
+}
+
+bool LogArchive::readDay(int dayNumber, std::vector<std::pair<std::shared_ptr<Food>, double>> &entries) const {
+    auto it = m_days.find(dayNumber);
+    if (it == m_days.end()) {
+        return false;
+    }
+    entries.clear();
+    size_t offset = it->second.offset;
+    for (size_t e = 0; e < it->second.entries; ++e) {
+        size_t foodIndex;
+        double servings;
+        decodeEntry(offset, foodIndex, servings);
+        if (m_foods[foodIndex]) {
+            entries.emplace_back(m_foods[foodIndex], servings);
+        }
+    }
+    return true;
+}
+
+bool LogArchive::dayTotal(int dayNumber, double &calories) const {
+    auto it = m_days.find(dayNumber);
+    if (it == m_days.end()) {
+        return false;
+    }
+    calories = 0.0;
+    bool logged = false;
+    size_t offset = it->second.offset;
+    for (size_t e = 0; e < it->second.entries; ++e) {
+        size_t foodIndex;
+        double servings;
+        decodeEntry(offset, foodIndex, servings);
+        if (m_foods[foodIndex]) {
+            calories += caloriesOf(*m_foods[foodIndex]) * servings;
+            logged = true;
+        }
+    }
+    return logged;
+}
+
+void LogArchive::forEachDayTotal(const std::function<void(int, double)> &fn) const {
+    for (const auto &[dayNumber, ref] : m_days) {
+        double calories;
+        if (dayTotal(dayNumber, calories)) {
+            fn(dayNumber, calories);
+        }
+    }
+}
+
+size_t LogArchive::dayCount() const {
+    return m_days.size();
+}
+
+bool LogArchive::isDamaged() const {
+    return m_damaged;
+}
@@ -0,0 +1,84 @@
+#ifndef LOG_ARCHIVE_H
+#define LOG_ARCHIVE_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "food/Food.h"
+#include "database/FoodDatabase.h"
+
+// Compact binary store for old days of a daily log.
+//
+// File layout (all integers are LEB128 varints):
+//   "YADAARC1"
+//   food count, then each food ID as length + bytes    (entries refer to foods by index)
+//   servings dictionary size, then each value as 8 raw bytes
+//   day count, then per day (ascending):
+//     zigzag delta from the previous day number, entry count,
+//     per entry: food index, servings code (0 = raw double follows, k = dictionary[k - 1])
+//
+// The encoded days stay in memory as bytes and are decoded only when a day is read or
+// totalled, so loading a decade of history is a single read and one index pass.
+class LogArchive
+{
+public:
+    // A day's entries by food ID, used when writing
+    using DayEntries = std::vector<std::pair<std::string, double>>;
+
+    LogArchive();
+
+    // Forget the loaded archive
+    void clear();
+
+    // Load an archive file and resolve its foods; false (and empty) if missing or corrupt
+    bool load(const std::string &path, const FoodDatabase &db);
+
+    // Add (or replace) days, write the whole archive to path and reload it
+    bool merge(const std::map<int, DayEntries> &days, const std::string &path, const FoodDatabase &db);
+
+    // Whether a day (day number) is archived
+    bool contains(int dayNumber) const;
+
+    // Decode a day's entries; foods no longer in the database are skipped
+    bool readDay(int dayNumber, std::vector<std::pair<std::shared_ptr<Food>, double>> &entries) const;
+
+    // Total calories of an archived day; false if it has no entries with known foods
+    bool dayTotal(int dayNumber, double &calories) const;
+
+    // Call fn(dayNumber, calories) for every archived day with known foods, in order
+    void forEachDayTotal(const std::function<void(int, double)> &fn) const;
+
+    size_t dayCount() const;
+
+    // True if the last load found a damaged file; merging would overwrite it, so it is refused
+    bool isDamaged() const;
+
+    // Archive file that belongs to a text log (daily_logs.txt -> daily_logs.archive)
+    static std::string pathFor(const std::string &logFilePath);
+
+private:
+    struct DayRef
+    {
+        size_t offset;  // Start of the day's entries in m_data
+        size_t entries; // Number of entries
+    };
+
+    // Decode one entry at offset; false if the data is truncated or out of range
+    bool decodeEntry(size_t &offset, size_t &foodIndex, double &servings) const;
+
+    // Parse a whole encoded archive into this object
+    bool parse(std::string data, const FoodDatabase &db);
+
+    std::vector<std::string> m_foodIds;              // Food index to ID
+    std::vector<std::shared_ptr<Food>> m_foods;      // Food index to food, null if unknown
+    std::vector<double> m_servingsDictionary;        // Common servings values
+    std::string m_data;                              // Encoded file contents
+    std::map<int, DayRef> m_days;                    // Day number to its entries
+    bool m_damaged;
+};
+
+#endif // LOG_ARCHIVE_H
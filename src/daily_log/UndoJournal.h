@@ -0,0 +1,74 @@
+#ifndef UNDO_JOURNAL_H
+#define UNDO_JOURNAL_H
+
+#include <cstddef>
+#include <vector>
+
+// Fixed-capacity undo/redo journal backed by a ring buffer.
+// Recording, undoing and redoing are O(1); once full, recording overwrites the oldest item.
+// Recording a new item discards everything that could still be redone.
+template <typename Item>
+class UndoJournal
+{
+public:
+    explicit UndoJournal(size_t capacity)
+        : m_items(capacity > 0 ? capacity : 1), m_start(0), m_undoCount(0), m_redoCount(0) {}
+
+    // Record a new action
+    void record(const Item &item)
+    {
+        m_redoCount = 0;
+        if (m_undoCount == m_items.size())
+        {
+            m_items[m_start] = item;
+            m_start = (m_start + 1) % m_items.size();
+        }
+        else
+        {
+            m_items[(m_start + m_undoCount) % m_items.size()] = item;
+            ++m_undoCount;
+        }
+    }
+
+    // Take the most recent action to undo; it becomes available to redo
+    bool popUndo(Item &item)
+    {
+        if (m_undoCount == 0)
+            return false;
+        --m_undoCount;
+        ++m_redoCount;
+        item = m_items[(m_start + m_undoCount) % m_items.size()];
+        return true;
+    }
+
+    // Take the most recently undone action to redo; it becomes available to undo again
+    bool popRedo(Item &item)
+    {
+        if (m_redoCount == 0)
+            return false;
+        item = m_items[(m_start + m_undoCount) % m_items.size()];
+        ++m_undoCount;
+        --m_redoCount;
+        return true;
+    }
+
+    // Forget all actions
+    void clear()
+    {
+        m_start = 0;
+        m_undoCount = 0;
+        m_redoCount = 0;
+    }
+
+    size_t undoSize() const { return m_undoCount; }
+    size_t redoSize() const { return m_redoCount; }
+    size_t capacity() const { return m_items.size(); }
+
+private:
+    std::vector<Item> m_items; // Ring buffer, allocated once
+    size_t m_start;            // Index of the oldest item
+    size_t m_undoCount;        // Items that can be undone, starting at m_start
+    size_t m_redoCount;        // Undone items following them that can be redone
+};
+
+#endif // UNDO_JOURNAL_H
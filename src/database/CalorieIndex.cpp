@@ -0,0 +1,99 @@
+#include "CalorieIndex.h"
+#include "../food/FoodDispatch.h"
+#include <iterator>
+#include <limits>
+
+void CalorieIndex::clear() {
+    ordered.clear();
+    positions.clear();
+}
+
+void CalorieIndex::update(const std::shared_ptr<Food>& food) {
+    const std::string id = food->getId();
+    double calories = caloriesOf(*food);
+
+    auto it = positions.find(id);
+    if (it != positions.end()) {
+        if (it->second == calories) {
+            ordered[Key(calories, id)] = food;
+            return;
+        }
+        ordered.erase(Key(it->second, id));
+        it->second = calories;
+    } else {
+        positions.emplace(id, calories);
+    }
+
+    ordered.emplace(Key(calories, id), food);
+}
+
+void CalorieIndex::remove(const std::string& id) {
+    auto it = positions.find(id);
+    if (it == positions.end()) {
+        return;
+    }
+    ordered.erase(Key(it->second, id));
+    positions.erase(it);
+}
+
+bool CalorieIndex::getCalories(const std::string& id, double& calories) const {
+    auto it = positions.find(id);
+    if (it == positions.end()) {
+        return false;
+    }
+    calories = it->second;
+    return true;
+}
+
+std::vector<std::shared_ptr<Food>> CalorieIndex::findInRange(double minCalories, double maxCalories) const {
+    std::vector<std::shared_ptr<Food>> result;
+
+    // The empty ID sorts before every other ID with the same calories
+    for (auto it = ordered.lower_bound(Key(minCalories, std::string()));
+         it != ordered.end() && it->first.first <= maxCalories; ++it) {
+        result.push_back(it->second);
+    }
+
+    return result;
+}
+
+std::vector<std::shared_ptr<Food>> CalorieIndex::findNearest(double targetCalories, size_t count) const {
+    std::vector<std::shared_ptr<Food>> result;
+
+    // Walk outwards from the target in both directions, always taking the closer neighbour
+    auto above = ordered.lower_bound(Key(targetCalories, std::string()));
+    auto below = above;
+    while (result.size() < count && (below != ordered.begin() || above != ordered.end())) {
+        double belowDistance = std::numeric_limits<double>::infinity();
+        double aboveDistance = std::numeric_limits<double>::infinity();
+        if (below != ordered.begin()) {
+            belowDistance = targetCalories - std::prev(below)->first.first;
+        }
+        if (above != ordered.end()) {
+            aboveDistance = above->first.first - targetCalories;
+        }
+
+        if (aboveDistance <= belowDistance) {
+            result.push_back(above->second);
+            ++above;
+        } else {
+            --below;
+            result.push_back(below->second);
+        }
+    }
+
+    return result;
+}
+
+void CalorieIndex::forEachFrom(double fromCalories,
+                               const std::function<bool(const std::shared_ptr<Food>&, double)>& visitor) const {
+    for (auto it = ordered.lower_bound(Key(fromCalories, std::string())); it != ordered.end(); ++it) {
+        if (!visitor(it->second, it->first.first)) {
+            break;
+        }
+    }
+}
+
+size_t CalorieIndex::size() const {
+    return ordered.size();
+}
@@ -0,0 +1,83 @@
+#ifndef CALORIE_INDEX_H
+#define CALORIE_INDEX_H
+
+#include "../food/Food.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Ordered index of foods by calories per serving
+ *
+ * Calories are captured when a food is indexed, so composite foods are not re-evaluated
+ * on every query. Callers re-index a food whenever its calories change.
+ */
+class CalorieIndex {
+public:
+    /**
+     * @brief Remove all foods from the index
+     */
+    void clear();
+
+    /**
+     * @brief Insert a food or move it to its current calorie value
+     * @param food The food to index
+     */
+    void update(const std::shared_ptr<Food>& food);
+
+    /**
+     * @brief Remove a food from the index
+     * @param id The ID of the food to remove
+     */
+    void remove(const std::string& id);
+
+    /**
+     * @brief Get the indexed calories of a food
+     * @param id The ID of the food
+     * @param calories Set to the indexed calories per serving if found
+     * @return true if the food is indexed, false otherwise
+     */
+    bool getCalories(const std::string& id, double& calories) const;
+
+    /**
+     * @brief Find foods whose calories per serving lie in [minCalories, maxCalories]
+     * @param minCalories Lower bound (inclusive)
+     * @param maxCalories Upper bound (inclusive)
+     * @return Matching foods in ascending calorie order
+     */
+    std::vector<std::shared_ptr<Food>> findInRange(double minCalories, double maxCalories) const;
+
+    /**
+     * @brief Find the foods whose calories per serving are closest to a target
+     * @param targetCalories The target calories per serving
+     * @param count Maximum number of foods to return
+     * @return Foods ordered by distance from the target, closest first
+     */
+    std::vector<std::shared_ptr<Food>> findNearest(double targetCalories, size_t count) const;
+
+    /**
+     * @brief Visit foods in ascending calorie order starting at a calorie value
+     * @param fromCalories First calorie value to visit (inclusive)
+     * @param visitor Called with each food and its calories; return false to stop
+     */
+    void forEachFrom(double fromCalories,
+                     const std::function<bool(const std::shared_ptr<Food>&, double)>& visitor) const;
+
+    /**
+     * @brief Get the number of indexed foods
+     * @return Number of foods
+     */
+    size_t size() const;
+
+private:
+    using Key = std::pair<double, std::string>; // Calories, then ID to break ties
+
+    std::map<Key, std::shared_ptr<Food>> ordered;     // Foods ordered by calories
+    std::unordered_map<std::string, double> positions; // ID to indexed calories
+};
+
+#endif // CALORIE_INDEX_H
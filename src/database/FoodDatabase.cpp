@@ -1,36 +1,86 @@
 #include "FoodDatabase.h"
+#include "FoodQuery.h"
+#include "../utils/FileHandler.h"
+#include "../utils/Metrics.h"
+#include "../utils/MemoryAccounting.h"
+#include "../utils/Tracer.h"
 #include <fstream>
+#include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <set>
+#include <filesystem>
+
+namespace {
+
+// Arena bytes reserved per byte of food file: a food in memory is a few times its text line
+const std::uintmax_t ARENA_BYTES_PER_FILE_BYTE = 4;
+
+} // namespace
 
 FoodDatabase::FoodDatabase(const std::string& basicFoodFilePath, const std::string& compositeFoodFilePath)
     : basicFoodFilePath(basicFoodFilePath), compositeFoodFilePath(compositeFoodFilePath) {}
 
 FoodDatabase::~FoodDatabase() {
-    // Automatically save foods on destruction
+    // Automatically save foods on destruction, unless a file changed on disk since this
+    // database last loaded or saved it: that is an outside edit or a newer save (by the
+    // persistence worker or the server), and writing this copy would undo it
+    if (stampOf(basicFoodFilePath) != basicFileStamp || stampOf(compositeFoodFilePath) != compositeFileStamp) {
+        return;
+    }
     saveFoods();
 }
 
+FoodDatabase::FileStamp FoodDatabase::stampOf(const std::string& path) {
+    FileStamp stamp;
+    std::error_code error;
+    std::filesystem::file_status status = std::filesystem::status(path, error);
+    if (error || !std::filesystem::exists(status)) {
+        return stamp;
+    }
+    stamp.size = std::filesystem::file_size(path, error);
+    stamp.modified = std::filesystem::last_write_time(path, error);
+    stamp.exists = !error;
+    return stamp;
+}
+
 bool FoodDatabase::loadFoods() {
+    TRACE_SCOPE("FoodDatabase::loadFoods");
+    Metrics::Timer timer(Metrics::Id::FOOD_LOAD);
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
     // Clear existing foods
     foods.clear();
+    keywordTable.invalidate();
+    basicFileStamp = stampOf(basicFoodFilePath);
+    compositeFileStamp = stampOf(compositeFoodFilePath);
+    
+    // The loaded foods share one arena, sized from the files so most loads need a single block;
+    // foods added later come from the heap
+    std::error_code error;
+    std::uintmax_t basicBytes = std::filesystem::file_size(basicFoodFilePath, error);
+    basicBytes = error ? 0 : basicBytes;
+    std::uintmax_t compositeBytes = std::filesystem::file_size(compositeFoodFilePath, error);
+    compositeBytes = error ? 0 : compositeBytes;
+    auto arena = FoodArena::create(static_cast<size_t>(ARENA_BYTES_PER_FILE_BYTE * (basicBytes + compositeBytes)));
     
     // Load basic foods first
-    if (!loadBasicFoods()) {
+    if (!loadBasicFoods(arena)) {
         std::cerr << "Error loading basic foods" << std::endl;
         return false;
     }
     
     // Then load composite foods (which may reference basic foods)
-    if (!loadCompositeFoods()) {
+    if (!loadCompositeFoods(arena)) {
         std::cerr << "Error loading composite foods" << std::endl;
         return false;
     }
     
+    rebuildIndexes();
     return true;
 }
 
-bool FoodDatabase::loadBasicFoods() {
+bool FoodDatabase::loadBasicFoods(const std::shared_ptr<FoodArena>& arena) {
+    TRACE_SCOPE("FoodDatabase::loadBasicFoods");
     std::ifstream file(basicFoodFilePath);
     if (!file) {
         std::cerr << "Could not open basic foods file: " << basicFoodFilePath << std::endl;
@@ -45,7 +95,7 @@ bool FoodDatabase::loadBasicFoods() {
         }
         
         try {
-            auto basicFood = BasicFood::fromString(line);
+            auto basicFood = BasicFood::fromString(line, arena);
             foods[basicFood->getId()] = basicFood;
         } catch (const std::exception& e) {
             std::cerr << "Error parsing basic food: " << e.what() << ", line: " << line << std::endl;
@@ -55,7 +105,8 @@ bool FoodDatabase::loadBasicFoods() {
     return true;
 }
 
-bool FoodDatabase::loadCompositeFoods() {
+bool FoodDatabase::loadCompositeFoods(const std::shared_ptr<FoodArena>& arena) {
+    TRACE_SCOPE("FoodDatabase::loadCompositeFoods");
     std::ifstream file(compositeFoodFilePath);
     if (!file) {
         std::cerr << "Could not open composite foods file: " << compositeFoodFilePath << std::endl;
@@ -70,7 +121,7 @@ bool FoodDatabase::loadCompositeFoods() {
         }
         
         try {
-            auto compositeFood = CompositeFood::fromString(line, foods);
+            auto compositeFood = CompositeFood::fromString(line, foods, arena);
             foods[compositeFood->getId()] = compositeFood;
         } catch (const std::exception& e) {
             std::cerr << "Error parsing composite food: " << e.what() << ", line: " << line << std::endl;
@@ -81,70 +132,308 @@ bool FoodDatabase::loadCompositeFoods() {
 }
 
 bool FoodDatabase::saveFoods() {
-    return saveBasicFoods() && saveCompositeFoods();
+    TRACE_SCOPE("FoodDatabase::saveFoods");
+    // Neither file is replaced unless both reached the disk; only a failed rename can still
+    // leave the basic foods replaced and the composites not
+    FileHandler::GroupCommit group;
+    if (!(saveBasicFoods() && saveCompositeFoods() && group.commit())) {
+        return false;
+    }
+    basicFileStamp = stampOf(basicFoodFilePath);
+    compositeFileStamp = stampOf(compositeFoodFilePath);
+    return true;
 }
 
 bool FoodDatabase::saveBasicFoods() {
-    std::ofstream file(basicFoodFilePath);
-    if (!file) {
-        std::cerr << "Could not open basic foods file for writing: " << basicFoodFilePath << std::endl;
-        return false;
-    }
-    
+    return FileHandler::writeFileAtomically(basicFoodFilePath, serializeBasicFoods());
+}
+
+bool FoodDatabase::saveCompositeFoods() {
+    return FileHandler::writeFileAtomically(compositeFoodFilePath, serializeCompositeFoods());
+}
+
+const std::string& FoodDatabase::getBasicFoodFilePath() const {
+    return basicFoodFilePath;
+}
+
+const std::string& FoodDatabase::getCompositeFoodFilePath() const {
+    return compositeFoodFilePath;
+}
+
+std::string FoodDatabase::serializeBasicFoods() const {
+    TRACE_SCOPE("FoodDatabase::serializeBasicFoods");
+    Metrics::Timer timer(Metrics::Id::FOOD_SERIALIZE);
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    std::ostringstream file;
     file << "# Basic Foods Database" << std::endl;
     file << "# Format: BASIC:id:keyword1,keyword2,...:calories" << std::endl;
     
     for (const auto& pair : foods) {
-        auto basicFood = std::dynamic_pointer_cast<BasicFood>(pair.second);
-        if (basicFood) {
-            file << basicFood->toString() << std::endl;
+        if (pair.second->getKind() == FoodKind::BASIC) {
+            file << pair.second->toString() << std::endl;
         }
     }
     
-    return true;
+    return file.str();
 }
 
-bool FoodDatabase::saveCompositeFoods() {
-    std::ofstream file(compositeFoodFilePath);
-    if (!file) {
-        std::cerr << "Could not open composite foods file for writing: " << compositeFoodFilePath << std::endl;
-        return false;
-    }
-    
+std::string FoodDatabase::serializeCompositeFoods() const {
+    TRACE_SCOPE("FoodDatabase::serializeCompositeFoods");
+    Metrics::Timer timer(Metrics::Id::FOOD_SERIALIZE);
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    std::ostringstream file;
     file << "# Composite Foods Database" << std::endl;
     file << "# Format: COMPOSITE:id:keyword1,keyword2,...:foodId=servings;foodId=servings;..." << std::endl;
     
     for (const auto& pair : foods) {
-        auto compositeFood = std::dynamic_pointer_cast<CompositeFood>(pair.second);
-        if (compositeFood) {
-            file << compositeFood->toString() << std::endl;
+        if (pair.second->getKind() == FoodKind::COMPOSITE) {
+            file << pair.second->toString() << std::endl;
         }
     }
     
-    return true;
+    return file.str();
 }
 
 bool FoodDatabase::addBasicFood(std::shared_ptr<BasicFood> food) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
     // Check if a food with this ID already exists
     if (foods.find(food->getId()) != foods.end()) {
         return false;
     }
     
     foods[food->getId()] = food;
+    searchCache.invalidateMatching(*food);
+    indexFood(food);
     return true;
 }
 
 bool FoodDatabase::addCompositeFood(std::shared_ptr<CompositeFood> food) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
     // Check if a food with this ID already exists
     if (foods.find(food->getId()) != foods.end()) {
         return false;
     }
     
     foods[food->getId()] = food;
+    searchCache.invalidateMatching(*food);
+    indexFood(food);
+    return true;
+}
+
+size_t FoodDatabase::addBasicFoods(const std::vector<std::shared_ptr<BasicFood>>& batch) {
+    TRACE_SCOPE("FoodDatabase::addBasicFoods");
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    size_t added = 0;
+    
+    for (const auto& food : batch) {
+        const std::string id = food->getId();
+        
+        // lower_bound doubles as the insertion hint, so sorted batches insert cheaply
+        auto it = foods.lower_bound(id);
+        if (it != foods.end() && it->first == id) {
+            continue;
+        }
+        
+        foods.emplace_hint(it, id, food);
+        ++added;
+    }
+    keywordTable.invalidate();
+    
+    return added;
+}
+
+void FoodDatabase::rebuildIndexes() {
+    TRACE_SCOPE("FoodDatabase::rebuildIndexes");
+    // The ID map is maintained on insert; derived indexes are rebuilt here
+    searchCache.clear();
+    
+    tagIndex.clear();
+    calorieIndex.clear();
+    dependents.clear();
+    for (const auto& pair : foods) {
+        indexFood(pair.second);
+    }
+}
+
+void FoodDatabase::indexFood(const std::shared_ptr<Food>& food) {
+    keywordTable.invalidate();
+    tagIndex.add(food);
+    calorieIndex.update(food);
+    
+    if (food->getKind() == FoodKind::COMPOSITE) {
+        linkComponents(static_cast<const CompositeFood&>(*food), true);
+    }
+}
+
+void FoodDatabase::linkComponents(const CompositeFood& compositeFood, bool present) {
+    const std::string id = compositeFood.getId();
+    for (const auto& component : compositeFood.getComponents()) {
+        const std::string componentId = component.food->getId();
+        if (present) {
+            dependents[componentId].push_back(id);
+            continue;
+        }
+        
+        auto it = dependents.find(componentId);
+        if (it == dependents.end()) {
+            continue;
+        }
+        auto& users = it->second;
+        users.erase(std::remove(users.begin(), users.end(), id), users.end());
+        if (users.empty()) {
+            dependents.erase(it);
+        }
+    }
+}
+
+bool FoodDatabase::contains(const std::string& containerId, const std::string& id) const {
+    // Walk up from id through the composites that use it
+    std::vector<std::string> pending{id};
+    std::set<std::string> visited{id};
+    
+    while (!pending.empty()) {
+        std::string current = pending.back();
+        pending.pop_back();
+        if (current == containerId) {
+            return true;
+        }
+        
+        auto it = dependents.find(current);
+        if (it == dependents.end()) {
+            continue;
+        }
+        for (const auto& dependent : it->second) {
+            if (visited.insert(dependent).second) {
+                pending.push_back(dependent);
+            }
+        }
+    }
+    return false;
+}
+
+void FoodDatabase::reindexCalories(const std::string& id) {
+    // Depth-first over composites that (transitively) contain the changed food; any order
+    // works, since each food's calories are computed live from its components
+    std::vector<std::string> pending{id};
+    std::set<std::string> visited{id};
+    
+    while (!pending.empty()) {
+        std::string current = pending.back();
+        pending.pop_back();
+        
+        auto food = getFoodById(current);
+        if (food) {
+            calorieIndex.update(food);
+        }
+        
+        auto it = dependents.find(current);
+        if (it == dependents.end()) {
+            continue;
+        }
+        for (const auto& dependent : it->second) {
+            if (visited.insert(dependent).second) {
+                pending.push_back(dependent);
+            }
+        }
+    }
+}
+
+bool FoodDatabase::updateBasicFoodCalories(const std::string& id, double calories) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    auto basicFood = std::dynamic_pointer_cast<BasicFood>(getFoodById(id));
+    if (!basicFood) {
+        return false;
+    }
+    
+    basicFood->setCaloriesPerServing(calories);
+    reindexCalories(id);
+    return true;
+}
+
+bool FoodDatabase::upsertBasicFood(const std::shared_ptr<BasicFood>& food) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    const std::string id = food->getId();
+    auto existing = getFoodById(id);
+    if (!existing) {
+        return addBasicFood(food);
+    }
+    auto basicFood = std::dynamic_pointer_cast<BasicFood>(existing);
+    if (!basicFood) {
+        return false;
+    }
+    
+    // Searches that matched the old keywords or could match the new ones are stale
+    searchCache.invalidateMatching(*basicFood);
+    tagIndex.remove(id);
+    basicFood->setKeywords(food->getKeywords());
+    basicFood->setCaloriesPerServing(food->getCaloriesPerServing());
+    tagIndex.add(basicFood);
+    keywordTable.invalidate();
+    searchCache.invalidateMatching(*basicFood);
+    
+    reindexCalories(id);
+    return true;
+}
+
+bool FoodDatabase::upsertCompositeFood(const std::shared_ptr<CompositeFood>& food) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    const std::string id = food->getId();
+    auto existing = getFoodById(id);
+    if (!existing) {
+        return addCompositeFood(food);
+    }
+    auto compositeFood = std::dynamic_pointer_cast<CompositeFood>(existing);
+    if (!compositeFood) {
+        return false;
+    }
+    
+    auto components = food->getComponents();
+    for (const auto& component : components) {
+        if (contains(component.food->getId(), id)) {
+            return false;
+        }
+    }
+    
+    searchCache.invalidateMatching(*compositeFood);
+    tagIndex.remove(id);
+    linkComponents(*compositeFood, false);
+    compositeFood->setKeywords(food->getKeywords());
+    compositeFood->setComponents(components);
+    linkComponents(*compositeFood, true);
+    tagIndex.add(compositeFood);
+    keywordTable.invalidate();
+    searchCache.invalidateMatching(*compositeFood);
+    
+    reindexCalories(id);
+    return true;
+}
+
+bool FoodDatabase::removeFood(const std::string& id) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    auto it = foods.find(id);
+    if (it == foods.end() || dependents.count(id) > 0) {
+        return false;
+    }
+    
+    std::shared_ptr<Food> food = it->second;
+    searchCache.invalidateMatching(*food);
+    tagIndex.remove(id);
+    keywordTable.invalidate();
+    calorieIndex.remove(id);
+    if (food->getKind() == FoodKind::COMPOSITE) {
+        linkComponents(static_cast<const CompositeFood&>(*food), false);
+    }
+    foods.erase(it);
     return true;
 }
 
-std::shared_ptr<Food> FoodDatabase::getFoodById(const std::string& id) const {
+std::shared_ptr<CompositeFood> FoodDatabase::parseCompositeFood(const std::string& line) const {
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    return CompositeFood::fromString(line, foods);
+}
+
+std::shared_ptr<Food> FoodDatabase::getFoodById(std::string_view id) const {
+    Metrics::Timer timer(Metrics::Id::FOOD_LOOKUP);
     auto it = foods.find(id);
     if (it != foods.end()) {
         return it->second;
@@ -152,32 +441,103 @@ std::shared_ptr<Food> FoodDatabase::getFoodById(const std::string& id) const {
     return nullptr;
 }
 
-std::vector<std::shared_ptr<Food>> FoodDatabase::findFoodsMatchingAllKeywords(
-    const std::vector<std::string>& keywords) const {
-    std::vector<std::shared_ptr<Food>> result;
+std::vector<std::shared_ptr<Food>> FoodDatabase::getFoodsByIds(const std::vector<std::string_view>& ids) const {
+    TRACE_SCOPE("FoodDatabase::getFoodsByIds");
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    std::vector<std::shared_ptr<Food>> result(ids.size());
     
-    for (const auto& pair : foods) {
-        if (pair.second->matchesAllKeywords(keywords)) {
-            result.push_back(pair.second);
+    // Visit the requested IDs in sorted order so they can be merged against the map
+    std::vector<size_t> order(ids.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&ids](size_t a, size_t b) { return ids[a] < ids[b]; });
+    
+    const size_t maxLinearSteps = 8; // Beyond this a fresh tree lookup is cheaper than walking
+    auto it = foods.begin();
+    for (size_t i = 0; i < order.size(); ++i) {
+        std::string_view id = ids[order[i]];
+        
+        if (i > 0 && id == ids[order[i - 1]]) {
+            result[order[i]] = result[order[i - 1]];
+            continue;
+        }
+        
+        size_t steps = 0;
+        while (it != foods.end() && std::string_view(it->first) < id && steps < maxLinearSteps) {
+            ++it;
+            ++steps;
+        }
+        if (it != foods.end() && std::string_view(it->first) < id) {
+            it = foods.lower_bound(id);
+        }
+        
+        if (it != foods.end() && it->first == id) {
+            result[order[i]] = it->second;
         }
     }
     
     return result;
 }
 
+std::vector<std::shared_ptr<Food>> FoodDatabase::findFoodsMatchingAllKeywords(
+    const std::vector<std::string>& keywords) const {
+    return findFoodsMatching(keywords, SearchCache::MatchMode::ALL);
+}
+
 std::vector<std::shared_ptr<Food>> FoodDatabase::findFoodsMatchingAnyKeyword(
     const std::vector<std::string>& keywords) const {
+    return findFoodsMatching(keywords, SearchCache::MatchMode::ANY);
+}
+
+std::vector<std::shared_ptr<Food>> FoodDatabase::findFoodsMatching(
+    const std::vector<std::string>& keywords, SearchCache::MatchMode mode) const {
+    TRACE_SCOPE("FoodDatabase::findFoodsMatching");
+    Metrics::Timer timer(Metrics::Id::FOOD_SEARCH);
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
     std::vector<std::shared_ptr<Food>> result;
     
-    for (const auto& pair : foods) {
-        if (pair.second->matchesAnyKeyword(keywords)) {
-            result.push_back(pair.second);
-        }
+    SearchCache::Query query = SearchCache::normalize(keywords, mode);
+    if (searchCache.lookup(query, result)) {
+        return result;
     }
     
+    result = keywordTable.findMatching(foods, query.terms, query.mode);
+    
+    searchCache.store(query, result);
     return result;
 }
 
+std::vector<std::shared_ptr<Food>> FoodDatabase::findFoodsMatchingQuery(const std::string& query) const {
+    TRACE_SCOPE("FoodDatabase::findFoodsMatchingQuery");
+    Metrics::Timer timer(Metrics::Id::FOOD_QUERY);
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    return FoodQuery::parse(query).evaluate(tagIndex, calorieIndex);
+}
+
+std::vector<std::shared_ptr<Food>> FoodDatabase::findFoodsInCalorieRange(double minCalories,
+                                                                         double maxCalories) const {
+    TRACE_SCOPE("FoodDatabase::findFoodsInCalorieRange");
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    return calorieIndex.findInRange(minCalories, maxCalories);
+}
+
+std::vector<std::shared_ptr<Food>> FoodDatabase::findFoodsNearestCalories(double targetCalories,
+                                                                          size_t count) const {
+    TRACE_SCOPE("FoodDatabase::findFoodsNearestCalories");
+    MemoryAccounting::Scope memoryScope(MemoryTag::FOOD_DATABASE);
+    return calorieIndex.findNearest(targetCalories, count);
+}
+
+void FoodDatabase::forEachFoodByCalories(
+    double fromCalories, const std::function<bool(const std::shared_ptr<Food>&, double)>& visitor) const {
+    calorieIndex.forEachFrom(fromCalories, visitor);
+}
+
+SearchCacheStats FoodDatabase::getSearchCacheStats() const {
+    return searchCache.getStats();
+}
+
 std::vector<std::shared_ptr<Food>> FoodDatabase::getAllFoods() const {
     std::vector<std::shared_ptr<Food>> result;
     
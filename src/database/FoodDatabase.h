@@ -4,8 +4,16 @@
 #include "../food/Food.h"
 #include "../food/BasicFood.h"
 #include "../food/CompositeFood.h"
+#include "CalorieIndex.h"
+#include "KeywordTable.h"
+#include "SearchCache.h"
+#include "TagIndex.h"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
 #include <map>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
 
@@ -37,6 +45,30 @@ public:
      * @return true if saving was successful, false otherwise
      */
     bool saveFoods();
+
+    /**
+     * @brief Render the basic foods file without writing it
+     * @return The file contents
+     */
+    std::string serializeBasicFoods() const;
+
+    /**
+     * @brief Render the composite foods file without writing it
+     * @return The file contents
+     */
+    std::string serializeCompositeFoods() const;
+
+    /**
+     * @brief Get the path of the basic foods file
+     * @return File path
+     */
+    const std::string& getBasicFoodFilePath() const;
+
+    /**
+     * @brief Get the path of the composite foods file
+     * @return File path
+     */
+    const std::string& getCompositeFoodFilePath() const;
     
     /**
      * @brief Add a basic food to the database
@@ -52,12 +84,77 @@ public:
      */
     bool addCompositeFood(std::shared_ptr<CompositeFood> food);
     
+    /**
+     * @brief Add a batch of basic foods without per-insert index maintenance
+     *
+     * Foods whose ID already exists are skipped. Callers must call rebuildIndexes()
+     * once after the last batch.
+     * @param batch Foods to add, ideally sorted by ID
+     * @return Number of foods actually added
+     */
+    size_t addBasicFoods(const std::vector<std::shared_ptr<BasicFood>>& batch);
+    
+    /**
+     * @brief Rebuild all lookup structures derived from the food map
+     */
+    void rebuildIndexes();
+    
+    /**
+     * @brief Change the calories of a basic food and re-index every food that depends on it
+     * @param id The ID of the basic food
+     * @param calories The new calories per serving
+     * @return true if the food was updated, false if no basic food has this ID
+     */
+    bool updateBasicFoodCalories(const std::string& id, double calories);
+    
+    /**
+     * @brief Add a basic food, or update an existing one in place
+     *
+     * Updating keeps the existing object, so composites and log entries that refer to it
+     * see the new keywords and calories.
+     * @param food The food as it should now be
+     * @return false if a composite food already has this ID
+     */
+    bool upsertBasicFood(const std::shared_ptr<BasicFood>& food);
+    
+    /**
+     * @brief Add a composite food, or update an existing one in place
+     * @param food The food as it should now be
+     * @return false if a basic food already has this ID, or the new components would make it contain itself
+     */
+    bool upsertCompositeFood(const std::shared_ptr<CompositeFood>& food);
+    
+    /**
+     * @brief Remove a food and drop it from every index
+     * @param id The ID of the food
+     * @return false if no food has this ID or a composite food still uses it
+     */
+    bool removeFood(const std::string& id);
+    
+    /**
+     * @brief Parse a composite food line against the foods currently in the database
+     * @param line Line in the composite foods file format
+     * @return The parsed food (not added to the database)
+     * @throws std::runtime_error if the line is malformed or names an unknown component
+     */
+    std::shared_ptr<CompositeFood> parseCompositeFood(const std::string& line) const;
+    
     /**
      * @brief Get a food by ID
      * @param id The ID of the food to get
      * @return Shared pointer to the food, or nullptr if not found
      */
-    std::shared_ptr<Food> getFoodById(const std::string& id) const;
+    std::shared_ptr<Food> getFoodById(std::string_view id) const;
+    
+    /**
+     * @brief Resolve many food IDs in one pass over the database
+     *
+     * IDs are sorted and merged against the ordered food map, so repeated and
+     * neighbouring IDs do not each pay a full tree lookup.
+     * @param ids The IDs to resolve
+     * @return Foods in the same order as ids, with nullptr for unknown IDs
+     */
+    std::vector<std::shared_ptr<Food>> getFoodsByIds(const std::vector<std::string_view>& ids) const;
     
     /**
      * @brief Find foods matching all the given keywords
@@ -73,6 +170,44 @@ public:
      */
     std::vector<std::shared_ptr<Food>> findFoodsMatchingAnyKeyword(const std::vector<std::string>& keywords) const;
     
+    /**
+     * @brief Find foods matching a boolean query
+     * @param query Query such as "protein AND NOT dairy AND calories<200" (see FoodQuery)
+     * @return Vector of matching foods, ordered by ID
+     * @throws std::invalid_argument if the query is malformed
+     */
+    std::vector<std::shared_ptr<Food>> findFoodsMatchingQuery(const std::string& query) const;
+    
+    /**
+     * @brief Find foods whose calories per serving lie in a range
+     * @param minCalories Lower bound (inclusive)
+     * @param maxCalories Upper bound (inclusive)
+     * @return Vector of matching foods in ascending calorie order
+     */
+    std::vector<std::shared_ptr<Food>> findFoodsInCalorieRange(double minCalories, double maxCalories) const;
+    
+    /**
+     * @brief Find the foods whose calories per serving are closest to a target
+     * @param targetCalories The target calories per serving
+     * @param count Maximum number of foods to return
+     * @return Vector of foods, closest first
+     */
+    std::vector<std::shared_ptr<Food>> findFoodsNearestCalories(double targetCalories, size_t count) const;
+    
+    /**
+     * @brief Visit foods in ascending calorie order
+     * @param fromCalories First calorie value to visit (inclusive)
+     * @param visitor Called with each food and its calories per serving; return false to stop
+     */
+    void forEachFoodByCalories(double fromCalories,
+                               const std::function<bool(const std::shared_ptr<Food>&, double)>& visitor) const;
+    
+    /**
+     * @brief Get the keyword search cache counters
+     * @return Hit, miss and invalidation statistics
+     */
+    SearchCacheStats getSearchCacheStats() const;
+    
     /**
      * @brief Get all foods in the database
      * @return Vector of all foods
@@ -85,22 +220,88 @@ public:
     void displayAllFoods() const;
 
 private:
+    /**
+     * @brief Size and modification time of a food file, to notice when it changed on disk
+     */
+    struct FileStamp {
+        bool exists = false;
+        std::uintmax_t size = 0;
+        std::filesystem::file_time_type modified;
+
+        bool operator==(const FileStamp& other) const {
+            return exists == other.exists && size == other.size && modified == other.modified;
+        }
+        bool operator!=(const FileStamp& other) const { return !(*this == other); }
+    };
+
     std::string basicFoodFilePath;    // Path to basic foods database file
     std::string compositeFoodFilePath; // Path to composite foods database file
+    FileStamp basicFileStamp;          // Both files as this database last loaded or saved them
+    FileStamp compositeFileStamp;
+    
+    std::map<std::string, std::shared_ptr<Food>, std::less<>> foods; // Map of food IDs to Food objects
+    mutable SearchCache searchCache; // LRU cache of keyword search results
+    KeywordTable keywordTable;       // All folded keywords in one buffer, for full scans
+    TagIndex tagIndex;               // Exact keyword bitmaps for boolean queries
+    CalorieIndex calorieIndex;       // Foods ordered by calories per serving
+    std::map<std::string, std::vector<std::string>> dependents; // Food ID to IDs of composites using it
     
-    std::map<std::string, std::shared_ptr<Food>> foods; // Map of food IDs to Food objects
+    /**
+     * @brief Get the current stamp of a file
+     * @param path Path to the file
+     * @return The stamp; exists is false if the file is missing
+     */
+    static FileStamp stampOf(const std::string& path);
+
+    /**
+     * @brief Add a food to every derived index
+     * @param food The food to index
+     */
+    void indexFood(const std::shared_ptr<Food>& food);
+    
+    /**
+     * @brief Re-index the calories of a food and of all composites built from it
+     * @param id The ID of the food whose calories changed
+     */
+    void reindexCalories(const std::string& id);
+    
+    /**
+     * @brief Record or forget that a composite uses each of its components
+     * @param compositeFood The composite food
+     * @param present Whether to add or remove its dependent links
+     */
+    void linkComponents(const CompositeFood& compositeFood, bool present);
+    
+    /**
+     * @brief Check whether a food is (transitively) a component of another
+     * @param containerId The ID of the possible container
+     * @param id The ID of the food to look for
+     * @return true if containerId is id or contains it
+     */
+    bool contains(const std::string& containerId, const std::string& id) const;
+    
+    /**
+     * @brief Run a keyword search through the search cache
+     * @param keywords List of keywords to match
+     * @param mode Whether any or all keywords must match
+     * @return Vector of matching foods
+     */
+    std::vector<std::shared_ptr<Food>> findFoodsMatching(const std::vector<std::string>& keywords,
+                                                         SearchCache::MatchMode mode) const;
     
     /**
      * @brief Load basic foods from database file
+     * @param arena Arena the loaded foods are created in
      * @return true if loading was successful, false otherwise
      */
-    bool loadBasicFoods();
+    bool loadBasicFoods(const std::shared_ptr<FoodArena>& arena);
     
     /**
      * @brief Load composite foods from database file
+     * @param arena Arena the loaded foods are created in
      * @return true if loading was successful, false otherwise
      */
-    bool loadCompositeFoods();
+    bool loadCompositeFoods(const std::shared_ptr<FoodArena>& arena);
     
     /**
      * @brief Save basic foods to database file
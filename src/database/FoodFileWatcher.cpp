@@ -0,0 +1,249 @@
+#include "FoodFileWatcher.h"
+#include <stdexcept>
+
+#ifdef __linux__
+#include "../utils/Tracer.h"
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+namespace {
+
+// Our own writes that may still be in flight (the persistence worker coalesces them)
+const size_t MAX_EXPECTED_WRITES = 16;
+
+bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+} // namespace
+
+FoodFileWatcher::FoodFileWatcher(FoodDatabase& db)
+    : db(db), inotifyFd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+    if (inotifyFd < 0) {
+        throw std::runtime_error(std::string("Could not start inotify: ") + std::strerror(errno));
+    }
+    track(basicFile, db.getBasicFoodFilePath());
+    track(compositeFile, db.getCompositeFoodFilePath());
+}
+
+FoodFileWatcher::~FoodFileWatcher() {
+    close(inotifyFd);
+}
+
+void FoodFileWatcher::track(WatchedFile& file, const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+    file.path = path;
+    file.name = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    // Saves replace the file by renaming over it, so watch for that as well as in-place writes
+    file.watch = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (file.watch < 0) {
+        throw std::runtime_error("Could not watch " + directory + ": " + std::strerror(errno));
+    }
+
+    std::string contents;
+    if (readFile(path, contents)) {
+        file.lines = foodLines(contents);
+    }
+}
+
+void FoodFileWatcher::noteWrite(const std::string& path, const std::string& contents) {
+    WatchedFile& file = path == basicFile.path ? basicFile : compositeFile;
+    file.lines = foodLines(contents);
+    file.expectedWrites.push_back(std::hash<std::string>()(contents));
+    if (file.expectedWrites.size() > MAX_EXPECTED_WRITES) {
+        file.expectedWrites.pop_front();
+    }
+}
+
+void FoodFileWatcher::readEvents() {
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return; // EAGAIN: nothing more queued
+        }
+
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0) {
+                for (WatchedFile* file : {&basicFile, &compositeFile}) {
+                    if (event->wd == file->watch && file->name == event->name) {
+                        file->changed = true;
+                    }
+                }
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+bool FoodFileWatcher::diff(WatchedFile& file, std::vector<std::string>& added, std::vector<std::string>& removed) {
+    file.changed = false;
+    std::string contents;
+    if (!readFile(file.path, contents)) {
+        return false;
+    }
+
+    // One of our writes landing: the synced lines already reflect it (or something newer)
+    size_t hash = std::hash<std::string>()(contents);
+    for (auto it = file.expectedWrites.begin(); it != file.expectedWrites.end(); ++it) {
+        if (*it == hash) {
+            file.expectedWrites.erase(file.expectedWrites.begin(), it + 1);
+            return false;
+        }
+    }
+
+    std::unordered_set<std::string> lines = foodLines(contents);
+    for (const auto& line : lines) {
+        if (file.lines.count(line) == 0) {
+            added.push_back(line);
+        }
+    }
+    for (const auto& line : file.lines) {
+        if (lines.count(line) == 0) {
+            removed.push_back(line);
+        }
+    }
+    file.lines = std::move(lines);
+    return !added.empty() || !removed.empty();
+}
+
+size_t FoodFileWatcher::poll() {
+    readEvents();
+
+    std::vector<std::string> basicAdded, basicRemoved, compositeAdded, compositeRemoved;
+    bool basicChanged = basicFile.changed && diff(basicFile, basicAdded, basicRemoved);
+    bool compositeChanged = compositeFile.changed && diff(compositeFile, compositeAdded, compositeRemoved);
+    if (!basicChanged && !compositeChanged) {
+        return 0;
+    }
+
+    // Traced only when something changed, so idle polls don't flood the trace
+    TRACE_SCOPE("FoodFileWatcher::poll");
+    size_t applied = 0;
+    std::set<std::string> rewritten; // IDs with a new line; their old line is an edit, not a removal
+
+    // Basic foods first, so new and edited composites can refer to them
+    for (const auto& line : basicAdded) {
+        rewritten.insert(lineId(line));
+        try {
+            if (db.upsertBasicFood(BasicFood::fromString(line))) {
+                ++applied;
+            } else {
+                std::cerr << "Warning: Ignoring basic food that clashes with a composite food: " << line << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error parsing basic food: " << e.what() << ", line: " << line << std::endl;
+        }
+    }
+
+    // Composites may use each other, so retry until a pass makes no progress
+    std::vector<std::string> pending = compositeAdded;
+    for (const auto& line : pending) {
+        rewritten.insert(lineId(line));
+    }
+    bool progress = true;
+    while (!pending.empty() && progress) {
+        progress = false;
+        std::vector<std::string> failed;
+        for (const auto& line : pending) {
+            try {
+                if (db.upsertCompositeFood(db.parseCompositeFood(line))) {
+                    ++applied;
+                    progress = true;
+                    continue;
+                }
+            } catch (const std::exception&) {
+            }
+            failed.push_back(line);
+        }
+        pending.swap(failed);
+    }
+    for (const auto& line : pending) {
+        std::cerr << "Warning: Could not apply composite food: " << line << std::endl;
+    }
+
+    // Remove users before what they use: composites, then basic foods
+    std::vector<std::string> removals;
+    for (const auto* lines : {&compositeRemoved, &basicRemoved}) {
+        for (const auto& line : *lines) {
+            std::string id = lineId(line);
+            if (!id.empty() && rewritten.count(id) == 0) {
+                removals.push_back(id);
+            }
+        }
+    }
+    progress = true;
+    while (!removals.empty() && progress) {
+        progress = false;
+        std::vector<std::string> failed;
+        for (const auto& id : removals) {
+            if (db.removeFood(id)) {
+                ++applied;
+                progress = true;
+            } else if (db.getFoodById(id)) {
+                failed.push_back(id);
+            }
+        }
+        removals.swap(failed);
+    }
+    for (const auto& id : removals) {
+        std::cerr << "Warning: Keeping " << id << " because a composite food still uses it" << std::endl;
+    }
+
+    return applied;
+}
+
+std::unordered_set<std::string> FoodFileWatcher::foodLines(const std::string& contents) {
+    std::unordered_set<std::string> lines;
+    std::istringstream stream(contents);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line[0] != '#') {
+            lines.insert(line);
+        }
+    }
+    return lines;
+}
+
+std::string FoodFileWatcher::lineId(const std::string& line) {
+    size_t start = line.find(':');
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = line.find(':', start + 1);
+    return line.substr(start + 1, end == std::string::npos ? std::string::npos : end - start - 1);
+}
+
+#else
+
+// inotify is Linux-only; elsewhere --watch reports that watching is unavailable
+FoodFileWatcher::FoodFileWatcher(FoodDatabase& db) : db(db), inotifyFd(-1) {
+    throw std::runtime_error("Watching the food files is not supported on this platform");
+}
+
+FoodFileWatcher::~FoodFileWatcher() {}
+
+size_t FoodFileWatcher::poll() {
+    return 0;
+}
+
+void FoodFileWatcher::noteWrite(const std::string&, const std::string&) {}
+
+#endif // __linux__
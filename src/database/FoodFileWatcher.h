@@ -0,0 +1,109 @@
+#ifndef FOOD_FILE_WATCHER_H
+#define FOOD_FILE_WATCHER_H
+
+#include "FoodDatabase.h"
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_set>
+
+/**
+ * @brief Applies outside edits of the food database files to a running database
+ *
+ * Watches the directory holding the food files with inotify (editors and atomic saves
+ * replace the file, so the file itself cannot be watched). When a file changes, its lines
+ * are diffed against the last state the database was in sync with, and only the added,
+ * changed and removed lines are applied. Writes made by this process are announced with
+ * noteWrite() and are not treated as outside edits.
+ */
+class FoodFileWatcher {
+public:
+    /**
+     * @brief Constructor for FoodFileWatcher; takes the current files as the synced state
+     * @param db The loaded database to keep up to date
+     * @throws std::runtime_error if inotify is not available
+     */
+    explicit FoodFileWatcher(FoodDatabase& db);
+
+    /**
+     * @brief Destructor for FoodFileWatcher; closes the inotify descriptor
+     */
+    ~FoodFileWatcher();
+
+    FoodFileWatcher(const FoodFileWatcher&) = delete;
+    FoodFileWatcher& operator=(const FoodFileWatcher&) = delete;
+
+    /**
+     * @brief Apply any outside edits that happened since the last call; never blocks
+     * @return Number of foods added, changed or removed
+     */
+    size_t poll();
+
+    /**
+     * @brief Record that this process is about to write a food file
+     * @param path Path of the file
+     * @param contents The contents being written
+     */
+    void noteWrite(const std::string& path, const std::string& contents);
+
+    /**
+     * @brief Get the descriptor that becomes readable when a watched file may have changed
+     * @return The inotify descriptor, for poll() or select() in an event loop
+     */
+    int descriptor() const { return inotifyFd; }
+
+private:
+    /**
+     * @brief Lines of one file as last synced, plus writes of ours not yet seen on disk
+     */
+    struct WatchedFile {
+        std::string path;
+        std::string name;                        // File name within the watched directory
+        int watch = -1;                          // inotify watch of that directory
+        std::unordered_set<std::string> lines;   // Food lines as last synced
+        std::deque<size_t> expectedWrites;       // Hashes of contents we wrote, oldest first
+        bool changed = false;                    // An event arrived since the last poll
+    };
+
+    FoodDatabase& db;
+    int inotifyFd;    // Non-blocking inotify instance
+    WatchedFile basicFile;
+    WatchedFile compositeFile;
+
+    /**
+     * @brief Set up a watched file from its current contents
+     * @param file The file to set up
+     * @param path Path of the file
+     */
+    void track(WatchedFile& file, const std::string& path);
+
+    /**
+     * @brief Read pending inotify events and mark the files they touch
+     */
+    void readEvents();
+
+    /**
+     * @brief Re-read a changed file and split it against the synced lines
+     * @param file The file to compare
+     * @param added Set to lines that are new on disk
+     * @param removed Set to lines that are gone from disk
+     * @return false if the change was our own write or the file could not be read
+     */
+    bool diff(WatchedFile& file, std::vector<std::string>& added, std::vector<std::string>& removed);
+
+    /**
+     * @brief Split file contents into food lines, skipping blanks and comments
+     * @param contents The file contents
+     * @return The food lines
+     */
+    static std::unordered_set<std::string> foodLines(const std::string& contents);
+
+    /**
+     * @brief Get the food ID of a line such as "BASIC:id:..."
+     * @param line The food line
+     * @return The ID, or an empty string if the line is malformed
+     */
+    static std::string lineId(const std::string& line);
+};
+
+#endif // FOOD_FILE_WATCHER_H
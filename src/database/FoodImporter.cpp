@@ -0,0 +1,220 @@
+#include "FoodImporter.h"
+#include "../utils/Tracer.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+// Trim spaces, tabs and carriage returns from both ends of a string
+std::string trim(const std::string& str) {
+    size_t begin = str.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = str.find_last_not_of(" \t\r");
+    return str.substr(begin, end - begin + 1);
+}
+
+// Split a row into columns, honouring double-quoted fields ("" is an escaped quote)
+std::vector<std::string> splitColumns(const std::string& line, char delimiter) {
+    std::vector<std::string> columns;
+    std::string current;
+    bool quoted = false;
+
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                current += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                current += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == delimiter) {
+            columns.push_back(current);
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    columns.push_back(current);
+
+    return columns;
+}
+
+// Lowercase, trim and deduplicate keywords, preserving their first-seen order
+std::vector<std::string> normalizeKeywords(const std::string& field) {
+    std::vector<std::string> keywords;
+    std::string keyword;
+
+    auto flush = [&]() {
+        keyword = trim(keyword);
+        std::transform(keyword.begin(), keyword.end(), keyword.begin(), ::tolower);
+        if (!keyword.empty() && std::find(keywords.begin(), keywords.end(), keyword) == keywords.end()) {
+            keywords.push_back(keyword);
+        }
+        keyword.clear();
+    };
+
+    for (char c : field) {
+        if (c == ',' || c == ';' || c == '|') {
+            flush();
+        } else {
+            keyword += c;
+        }
+    }
+    flush();
+
+    return keywords;
+}
+
+// Characters that would corrupt the food or log file formats
+bool hasReservedCharacter(const std::string& str) {
+    return str.find_first_of(":,\n") != std::string::npos;
+}
+
+} // namespace
+
+double ImportReport::rowsPerSecond() const {
+    return seconds > 0.0 ? rowsRead / seconds : 0.0;
+}
+
+FoodImporter::FoodImporter(FoodDatabase& database, size_t batchSize)
+    : database(database), batchSize(batchSize > 0 ? batchSize : 1) {}
+
+ImportReport FoodImporter::importFile(const std::string& filePath) {
+    std::ifstream file(filePath);
+    if (!file) {
+        throw std::runtime_error("Could not open import file: " + filePath);
+    }
+
+    char delimiter = '\0';
+    if (filePath.size() >= 4) {
+        std::string extension = filePath.substr(filePath.size() - 4);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (extension == ".tsv") {
+            delimiter = '\t';
+        }
+    }
+
+    return importStream(file, delimiter);
+}
+
+ImportReport FoodImporter::importStream(std::istream& in, char delimiter) {
+    TRACE_SCOPE("FoodImporter::importStream");
+    ImportReport report;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::shared_ptr<BasicFood>> batch;
+    batch.reserve(batchSize);
+
+    std::string line;
+    bool firstDataRow = true;
+    while (std::getline(in, line)) {
+        // Skip empty lines or comments
+        if (line.empty() || line[0] == '#' || trim(line).empty()) {
+            continue;
+        }
+
+        if (firstDataRow) {
+            firstDataRow = false;
+            if (delimiter == '\0') {
+                delimiter = line.find('\t') != std::string::npos ? '\t' : ',';
+            }
+
+            // A leading header row such as "id,keywords,calories" is not data
+            auto columns = splitColumns(line, delimiter);
+            std::string firstColumn = trim(columns[0]);
+            std::transform(firstColumn.begin(), firstColumn.end(), firstColumn.begin(), ::tolower);
+            if (firstColumn == "id") {
+                continue;
+            }
+        }
+
+        ++report.rowsRead;
+        auto food = parseRow(line, delimiter);
+        if (!food) {
+            ++report.rejectedMalformed;
+            continue;
+        }
+
+        batch.push_back(food);
+        if (batch.size() >= batchSize) {
+            flushBatch(batch, report);
+        }
+    }
+    flushBatch(batch, report);
+
+    // One index rebuild for the whole import instead of one per inserted food
+    database.rebuildIndexes();
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+std::shared_ptr<BasicFood> FoodImporter::parseRow(const std::string& line, char delimiter) {
+    auto columns = splitColumns(line, delimiter);
+    if (columns.size() != 3) {
+        return nullptr;
+    }
+
+    std::string id = trim(columns[0]);
+    if (id.empty() || hasReservedCharacter(id)) {
+        return nullptr;
+    }
+
+    auto keywords = normalizeKeywords(columns[1]);
+    for (const auto& keyword : keywords) {
+        if (hasReservedCharacter(keyword)) {
+            return nullptr;
+        }
+    }
+
+    std::string caloriesStr = trim(columns[2]);
+    if (caloriesStr.empty()) {
+        return nullptr;
+    }
+    char* end = nullptr;
+    double calories = std::strtod(caloriesStr.c_str(), &end);
+    if (end != caloriesStr.c_str() + caloriesStr.size() || !std::isfinite(calories) || calories < 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<BasicFood>(id, keywords, calories);
+}
+
+void FoodImporter::flushBatch(std::vector<std::shared_ptr<BasicFood>>& batch, ImportReport& report) {
+    TRACE_SCOPE("FoodImporter::flushBatch");
+    if (batch.empty()) {
+        return;
+    }
+
+    // Sort by ID so duplicates inside the batch are adjacent and insertion walks the map in order;
+    // stable so the first occurrence in the file wins
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const std::shared_ptr<BasicFood>& a, const std::shared_ptr<BasicFood>& b) {
+                         return a->getId() < b->getId();
+                     });
+    auto last = std::unique(batch.begin(), batch.end(),
+                            [](const std::shared_ptr<BasicFood>& a, const std::shared_ptr<BasicFood>& b) {
+                                return a->getId() == b->getId();
+                            });
+    size_t unique = static_cast<size_t>(last - batch.begin());
+    report.rejectedDuplicate += batch.size() - unique;
+    batch.erase(last, batch.end());
+
+    size_t inserted = database.addBasicFoods(batch);
+    report.imported += inserted;
+    report.rejectedDuplicate += unique - inserted;
+
+    batch.clear();
+}
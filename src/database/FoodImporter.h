@@ -0,0 +1,80 @@
+#ifndef FOOD_IMPORTER_H
+#define FOOD_IMPORTER_H
+
+#include "FoodDatabase.h"
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Summary of a bulk import run
+ */
+struct ImportReport {
+    size_t rowsRead = 0;          // Data rows seen (comments, blank lines and header excluded)
+    size_t imported = 0;          // Rows inserted into the database
+    size_t rejectedMalformed = 0; // Rows that could not be parsed
+    size_t rejectedDuplicate = 0; // Rows whose ID already existed (in the database or earlier in the file)
+    double seconds = 0.0;         // Wall-clock duration of the import
+
+    /**
+     * @brief Get the import throughput
+     * @return Rows read per second
+     */
+    double rowsPerSecond() const;
+};
+
+/**
+ * @brief Streams basic foods from external CSV/TSV nutrition dumps into a FoodDatabase
+ *
+ * Each data row has the columns id, keywords and calories per serving. Keywords inside
+ * their column may be separated by ',', ';' or '|' (quote the column in CSV files when
+ * using ','). Rows are parsed and normalized in batches, deduplicated against existing
+ * IDs and inserted without per-insert index maintenance; indexes are rebuilt once at the end.
+ */
+class FoodImporter {
+public:
+    /**
+     * @brief Constructor for FoodImporter
+     * @param database The database to import into
+     * @param batchSize Number of parsed rows inserted per batch
+     */
+    explicit FoodImporter(FoodDatabase& database, size_t batchSize = 65536);
+
+    /**
+     * @brief Import foods from a file
+     * @param filePath Path to the CSV or TSV file; ".tsv" files use tabs, others are sniffed
+     * @return Report of the import run
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    ImportReport importFile(const std::string& filePath);
+
+    /**
+     * @brief Import foods from a stream
+     * @param in The stream to read rows from
+     * @param delimiter Column delimiter, or '\0' to detect it from the first data row
+     * @return Report of the import run
+     */
+    ImportReport importStream(std::istream& in, char delimiter = '\0');
+
+private:
+    FoodDatabase& database; // Destination database
+    size_t batchSize;       // Rows per insertion batch
+
+    /**
+     * @brief Parse one data row into a basic food
+     * @param line The row text
+     * @param delimiter Column delimiter
+     * @return The parsed food, or nullptr if the row is malformed
+     */
+    static std::shared_ptr<BasicFood> parseRow(const std::string& line, char delimiter);
+
+    /**
+     * @brief Deduplicate a batch and insert it into the database
+     * @param batch Parsed foods; cleared on return
+     * @param report Report updated with imported and duplicate counts
+     */
+    void flushBatch(std::vector<std::shared_ptr<BasicFood>>& batch, ImportReport& report);
+};
+
+#endif // FOOD_IMPORTER_H
@@ -0,0 +1,401 @@
+#include "FoodQuery.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+using Node = FoodQuery::Node;
+using NodePtr = std::shared_ptr<const Node>;
+
+struct Token {
+    enum class Type { WORD, LPAREN, RPAREN, COMPARISON, END } type;
+    std::string text;
+    bool quoted = false;
+};
+
+std::string toLower(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+    return str;
+}
+
+std::vector<Token> tokenize(const std::string& text) {
+    std::vector<Token> tokens;
+    size_t i = 0;
+
+    while (i < text.size()) {
+        char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '(') {
+            tokens.push_back({Token::Type::LPAREN, "("});
+            ++i;
+        } else if (c == ')') {
+            tokens.push_back({Token::Type::RPAREN, ")"});
+            ++i;
+        } else if (c == '<' || c == '>' || c == '=') {
+            std::string op(1, c);
+            if (c != '=' && i + 1 < text.size() && text[i + 1] == '=') {
+                op += '=';
+            }
+            tokens.push_back({Token::Type::COMPARISON, op});
+            i += op.size();
+        } else if (c == '"') {
+            size_t end = text.find('"', i + 1);
+            if (end == std::string::npos) {
+                throw std::invalid_argument("Unterminated quote in query");
+            }
+            tokens.push_back({Token::Type::WORD, text.substr(i + 1, end - i - 1), true});
+            i = end + 1;
+        } else {
+            size_t start = i;
+            while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])) &&
+                   std::string("()<>=\"").find(text[i]) == std::string::npos) {
+                ++i;
+            }
+            tokens.push_back({Token::Type::WORD, text.substr(start, i - start)});
+        }
+    }
+
+    tokens.push_back({Token::Type::END, ""});
+    return tokens;
+}
+
+// Recursive-descent parser over the token list
+class Parser {
+public:
+    explicit Parser(const std::string& text) : tokens(tokenize(text)) {}
+
+    NodePtr parseQuery() {
+        NodePtr node = parseOr();
+        if (peek().type != Token::Type::END) {
+            throw std::invalid_argument("Unexpected '" + peek().text + "' in query");
+        }
+        return node;
+    }
+
+private:
+    std::vector<Token> tokens;
+    size_t position = 0;
+
+    const Token& peek() const { return tokens[position]; }
+
+    bool isOperator(const Token& token, const char* name) const {
+        return token.type == Token::Type::WORD && !token.quoted && toLower(token.text) == name;
+    }
+
+    // Start of a unary expression, used to detect implicit AND
+    bool startsUnary(const Token& token) const {
+        return token.type == Token::Type::LPAREN ||
+               (token.type == Token::Type::WORD && !isOperator(token, "and") && !isOperator(token, "or"));
+    }
+
+    NodePtr parseOr() {
+        std::vector<NodePtr> operands{parseAnd()};
+        while (isOperator(peek(), "or")) {
+            ++position;
+            operands.push_back(parseAnd());
+        }
+        return combine(Node::Type::OR, operands);
+    }
+
+    NodePtr parseAnd() {
+        std::vector<NodePtr> operands{parseUnary()};
+        while (true) {
+            if (isOperator(peek(), "and")) {
+                ++position;
+            } else if (!startsUnary(peek())) {
+                break;
+            }
+            operands.push_back(parseUnary());
+        }
+        return combine(Node::Type::AND, operands);
+    }
+
+    NodePtr parseUnary() {
+        const Token& token = peek();
+
+        if (isOperator(token, "not")) {
+            ++position;
+            auto node = std::make_shared<Node>();
+            node->type = Node::Type::NOT;
+            node->children.push_back(parseUnary());
+            return node;
+        }
+
+        if (token.type == Token::Type::LPAREN) {
+            ++position;
+            NodePtr node = parseOr();
+            if (peek().type != Token::Type::RPAREN) {
+                throw std::invalid_argument("Missing ')' in query");
+            }
+            ++position;
+            return node;
+        }
+
+        if (token.type != Token::Type::WORD || isOperator(token, "and") || isOperator(token, "or")) {
+            throw std::invalid_argument(token.type == Token::Type::END
+                                            ? "Query ended where a term was expected"
+                                            : "Expected a term but found '" + token.text + "'");
+        }
+        ++position;
+
+        auto node = std::make_shared<Node>();
+        if (peek().type != Token::Type::COMPARISON) {
+            node->type = Node::Type::TAG;
+            node->tag = toLower(token.text);
+            return node;
+        }
+
+        std::string field = toLower(token.text);
+        if (token.quoted || (field != "calories" && field != "cal")) {
+            throw std::invalid_argument("Only calories can be compared, not '" + token.text + "'");
+        }
+
+        std::string op = tokens[position++].text;
+        node->type = Node::Type::CALORIES;
+        node->comparison = op == "<"  ? FoodQuery::Comparison::LESS
+                         : op == "<=" ? FoodQuery::Comparison::LESS_EQUAL
+                         : op == ">"  ? FoodQuery::Comparison::GREATER
+                         : op == ">=" ? FoodQuery::Comparison::GREATER_EQUAL
+                                      : FoodQuery::Comparison::EQUAL;
+
+        const Token& number = peek();
+        char* end = nullptr;
+        node->value = number.type == Token::Type::WORD ? std::strtod(number.text.c_str(), &end) : 0.0;
+        if (number.type != Token::Type::WORD || end != number.text.c_str() + number.text.size() ||
+            number.text.empty() || !std::isfinite(node->value)) {
+            throw std::invalid_argument("Expected a number after '" + op + "'");
+        }
+        ++position;
+
+        return node;
+    }
+
+    // Collapse single-operand chains and flatten nested operators of the same type
+    static NodePtr combine(Node::Type type, const std::vector<NodePtr>& operands) {
+        if (operands.size() == 1) {
+            return operands[0];
+        }
+        auto node = std::make_shared<Node>();
+        node->type = type;
+        for (const auto& operand : operands) {
+            if (operand->type == type) {
+                node->children.insert(node->children.end(), operand->children.begin(), operand->children.end());
+            } else {
+                node->children.push_back(operand);
+            }
+        }
+        return node;
+    }
+};
+
+// Evaluates a query tree as bitmap operations, most selective operands first
+class Evaluator {
+public:
+    Evaluator(const TagIndex& index, const CalorieIndex& calorieIndex)
+        : index(index), calorieIndex(calorieIndex) {}
+
+    TagBitmap evaluate(const Node& node) {
+        switch (node.type) {
+            case Node::Type::TAG: {
+                const TagBitmap* bitmap = index.find(node.tag);
+                return bitmap ? *bitmap : TagBitmap();
+            }
+            case Node::Type::CALORIES:
+                return scanCalories(node);
+            case Node::Type::NOT:
+                return TagBitmap::subtract(universe(), evaluate(*node.children[0]));
+            case Node::Type::OR: {
+                TagBitmap result;
+                for (const auto& child : node.children) {
+                    result = TagBitmap::unite(result, evaluate(*child));
+                }
+                return result;
+            }
+            case Node::Type::AND:
+                return evaluateAnd(node);
+        }
+        return TagBitmap();
+    }
+
+private:
+    const TagIndex& index;
+    const CalorieIndex& calorieIndex;
+    std::unique_ptr<TagBitmap> allSlots; // Lazily built bitmap of every slot
+
+    const TagBitmap& universe() {
+        if (!allSlots) {
+            allSlots.reset(new TagBitmap(TagBitmap::range(static_cast<uint32_t>(index.size()))));
+        }
+        return *allSlots;
+    }
+
+    // Upper bound on the number of matches, used to order AND operands
+    size_t estimate(const Node& node) const {
+        switch (node.type) {
+            case Node::Type::TAG: {
+                const TagBitmap* bitmap = index.find(node.tag);
+                return bitmap ? bitmap->cardinality() : 0;
+            }
+            case Node::Type::NOT:
+                return index.size() - std::min(index.size(), estimate(*node.children[0]));
+            case Node::Type::AND: {
+                size_t smallest = index.size();
+                for (const auto& child : node.children) {
+                    smallest = std::min(smallest, estimate(*child));
+                }
+                return smallest;
+            }
+            case Node::Type::OR: {
+                size_t total = 0;
+                for (const auto& child : node.children) {
+                    total += estimate(*child);
+                }
+                return std::min(total, index.size());
+            }
+            case Node::Type::CALORIES:
+                return index.size();
+        }
+        return index.size();
+    }
+
+    TagBitmap evaluateAnd(const Node& node) {
+        std::vector<std::pair<size_t, const Node*>> positives;
+        std::vector<std::pair<size_t, const Node*>> negatives;
+        std::vector<const Node*> filters;
+
+        for (const auto& child : node.children) {
+            if (child->type == Node::Type::CALORIES) {
+                filters.push_back(child.get()); // Needs per-food evaluation, so applied last
+            } else if (child->type == Node::Type::NOT) {
+                negatives.emplace_back(estimate(*child->children[0]), child->children[0].get());
+            } else {
+                positives.emplace_back(estimate(*child), child.get());
+            }
+        }
+
+        // Plan: intersect from the most selective operand, then subtract the largest exclusions
+        std::sort(positives.begin(), positives.end(),
+                  [](const std::pair<size_t, const Node*>& a, const std::pair<size_t, const Node*>& b) {
+                      return a.first < b.first;
+                  });
+        std::sort(negatives.begin(), negatives.end(),
+                  [](const std::pair<size_t, const Node*>& a, const std::pair<size_t, const Node*>& b) {
+                      return a.first > b.first;
+                  });
+
+        TagBitmap result = positives.empty() ? universe() : evaluate(*positives[0].second);
+        for (size_t i = 1; i < positives.size() && !result.empty(); ++i) {
+            result = intersectWith(result, *positives[i].second);
+        }
+        for (size_t i = 0; i < negatives.size() && !result.empty(); ++i) {
+            result = subtractWith(result, *negatives[i].second);
+        }
+        for (size_t i = 0; i < filters.size() && !result.empty(); ++i) {
+            result = filterCalories(result, *filters[i]);
+        }
+
+        return result;
+    }
+
+    // Tag operands are used in place instead of being copied out of the index
+    TagBitmap intersectWith(const TagBitmap& current, const Node& node) {
+        if (node.type == Node::Type::TAG) {
+            const TagBitmap* bitmap = index.find(node.tag);
+            return bitmap ? TagBitmap::intersect(current, *bitmap) : TagBitmap();
+        }
+        return TagBitmap::intersect(current, evaluate(node));
+    }
+
+    TagBitmap subtractWith(const TagBitmap& current, const Node& node) {
+        if (node.type == Node::Type::TAG) {
+            const TagBitmap* bitmap = index.find(node.tag);
+            return bitmap ? TagBitmap::subtract(current, *bitmap) : current;
+        }
+        return TagBitmap::subtract(current, evaluate(node));
+    }
+
+    static bool compare(double calories, const Node& node) {
+        switch (node.comparison) {
+            case FoodQuery::Comparison::LESS: return calories < node.value;
+            case FoodQuery::Comparison::LESS_EQUAL: return calories <= node.value;
+            case FoodQuery::Comparison::GREATER: return calories > node.value;
+            case FoodQuery::Comparison::GREATER_EQUAL: return calories >= node.value;
+            case FoodQuery::Comparison::EQUAL: return calories == node.value;
+        }
+        return false;
+    }
+
+    // Check candidates against the calories cached in the calorie index
+    TagBitmap filterCalories(const TagBitmap& candidates, const Node& node) const {
+        TagBitmap result;
+        for (uint32_t slot : candidates.toVector()) {
+            double calories = 0.0;
+            if (calorieIndex.getCalories(index.foodAt(slot)->getId(), calories) && compare(calories, node)) {
+                result.add(slot);
+            }
+        }
+        return result;
+    }
+
+    // Standalone comparison: walk only the matching range of the calorie index
+    TagBitmap scanCalories(const Node& node) const {
+        bool upperBounded = node.comparison == FoodQuery::Comparison::LESS ||
+                            node.comparison == FoodQuery::Comparison::LESS_EQUAL;
+        double from = upperBounded ? -std::numeric_limits<double>::infinity() : node.value;
+
+        std::vector<uint32_t> slots;
+        calorieIndex.forEachFrom(from, [&](const std::shared_ptr<Food>& food, double calories) {
+            if (!compare(calories, node)) {
+                // Past the range for upper bounds and equality; "> value" only skips equal values
+                return node.comparison == FoodQuery::Comparison::GREATER && calories == node.value;
+            }
+            uint32_t slot = 0;
+            if (index.findSlot(food->getId(), slot)) {
+                slots.push_back(slot);
+            }
+            return true;
+        });
+
+        std::sort(slots.begin(), slots.end());
+        TagBitmap result;
+        for (uint32_t slot : slots) {
+            result.add(slot);
+        }
+        return result;
+    }
+};
+
+} // namespace
+
+FoodQuery::FoodQuery(std::shared_ptr<const Node> root) : root(root) {}
+
+FoodQuery FoodQuery::parse(const std::string& text) {
+    Parser parser(text);
+    return FoodQuery(parser.parseQuery());
+}
+
+std::vector<std::shared_ptr<Food>> FoodQuery::evaluate(const TagIndex& index,
+                                                       const CalorieIndex& calorieIndex) const {
+    Evaluator evaluator(index, calorieIndex);
+    std::vector<uint32_t> slots = evaluator.evaluate(*root).toVector();
+
+    std::vector<std::shared_ptr<Food>> result;
+    result.reserve(slots.size());
+    for (uint32_t slot : slots) {
+        result.push_back(index.foodAt(slot));
+    }
+
+    if (!index.isSortedById()) {
+        std::sort(result.begin(), result.end(),
+                  [](const std::shared_ptr<Food>& a, const std::shared_ptr<Food>& b) {
+                      return a->getId() < b->getId();
+                  });
+    }
+
+    return result;
+}
@@ -0,0 +1,62 @@
+#ifndef FOOD_QUERY_H
+#define FOOD_QUERY_H
+
+#include "CalorieIndex.h"
+#include "TagIndex.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Parsed boolean query over food keywords and calories
+ *
+ * Grammar (operators are case-insensitive, adjacent terms are implicitly ANDed):
+ *   query   := or
+ *   or      := and ("OR" and)*
+ *   and     := unary (["AND"] unary)*
+ *   unary   := "NOT" unary | "(" query ")" | term
+ *   term    := keyword | "calories" ("<" | "<=" | ">" | ">=" | "=") number
+ * Keywords match food keywords exactly (case-insensitive); quote them to use spaces
+ * or operator words, e.g. "green tea" AND NOT dairy AND calories<200.
+ */
+class FoodQuery {
+public:
+    /**
+     * @brief Parse a query string
+     * @param text The query text
+     * @return The parsed query
+     * @throws std::invalid_argument if the query is malformed
+     */
+    static FoodQuery parse(const std::string& text);
+
+    /**
+     * @brief Evaluate the query against the database indexes
+     * @param index The tag index to evaluate against
+     * @param calorieIndex The calorie index used for calorie comparisons
+     * @return Matching foods, ordered by ID
+     */
+    std::vector<std::shared_ptr<Food>> evaluate(const TagIndex& index, const CalorieIndex& calorieIndex) const;
+
+    /**
+     * @brief Comparison operators for calorie terms
+     */
+    enum class Comparison { LESS, LESS_EQUAL, GREATER, GREATER_EQUAL, EQUAL };
+
+    /**
+     * @brief Node of the parsed query tree
+     */
+    struct Node {
+        enum class Type { TAG, CALORIES, AND, OR, NOT } type;
+        std::string tag;                          // Lowercased keyword for TAG nodes
+        Comparison comparison = Comparison::EQUAL; // Operator for CALORIES nodes
+        double value = 0.0;                       // Operand for CALORIES nodes
+        std::vector<std::shared_ptr<const Node>> children; // Operands for AND, OR and NOT
+    };
+
+private:
+    std::shared_ptr<const Node> root; // Root of the query tree
+
+    explicit FoodQuery(std::shared_ptr<const Node> root);
+};
+
+#endif // FOOD_QUERY_H
@@ -0,0 +1,105 @@
+#include "KeywordTable.h"
+#include "../utils/StringSearch.h"
+#include <algorithm>
+
+void KeywordTable::invalidate() {
+    stale.store(true, std::memory_order_release);
+}
+
+std::vector<std::shared_ptr<Food>> KeywordTable::findMatching(const FoodMap& foods,
+                                                              const std::vector<std::string>& terms,
+                                                              SearchCache::MatchMode mode) const {
+    refresh(foods);
+    std::vector<std::shared_ptr<Food>> result;
+    if (terms.empty()) {
+        result = entries;
+        return result;
+    }
+
+    // ALL advances a food once per term, and only if it matched every earlier term;
+    // ANY marks a food on its first matching term
+    bool all = mode == SearchCache::MatchMode::ALL;
+    std::vector<uint32_t> matched(entries.size(), 0);
+    size_t count = 0;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        uint32_t required = all ? static_cast<uint32_t>(i) : 0;
+        size_t marked = markTerm(terms[i], matched, required);
+        count = all ? marked : count + marked;
+        if (count == 0 && all) {
+            return result;
+        }
+    }
+
+    uint32_t needed = all ? static_cast<uint32_t>(terms.size()) : 1;
+    result.reserve(count);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (matched[i] == needed) {
+            result.push_back(entries[i]);
+        }
+    }
+    return result;
+}
+
+void KeywordTable::refresh(const FoodMap& foods) const {
+    if (!stale.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(rebuildMutex);
+    if (!stale.load(std::memory_order_relaxed)) {
+        return; // Another search rebuilt it meanwhile
+    }
+
+    text.clear();
+    ends.clear();
+    entries.clear();
+    ends.reserve(foods.size());
+    entries.reserve(foods.size());
+    for (const auto& pair : foods) {
+        text += pair.second->getFoldedKeywords();
+        ends.push_back(text.size());
+        entries.push_back(pair.second);
+    }
+    stale.store(false, std::memory_order_release);
+}
+
+size_t KeywordTable::markTerm(const std::string& term, std::vector<uint32_t>& matched, uint32_t required) const {
+    size_t marked = 0;
+
+    // An empty term is a substring of every keyword, so it needs at least one
+    if (term.empty()) {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            size_t begin = i == 0 ? 0 : ends[i - 1];
+            if (ends[i] > begin && matched[i] == required) {
+                matched[i] = required + 1;
+                ++marked;
+            }
+        }
+        return marked;
+    }
+
+    size_t food = 0;
+    size_t position = StringSearch::find(text, term);
+    while (position != std::string::npos) {
+        food = foodAt(position, food);
+        // Keywords end in '\0', so only a term holding '\0' could run into the next food
+        if (position + term.size() <= ends[food] && matched[food] == required) {
+            matched[food] = required + 1;
+            ++marked;
+        }
+        // One hit per food is enough; resume at the next food
+        position = StringSearch::find(text, term, ends[food]);
+    }
+    return marked;
+}
+
+size_t KeywordTable::foodAt(size_t position, size_t from) const {
+    // Hits usually land a few foods ahead, so gallop forward before the binary search
+    size_t low = from;
+    size_t step = 1;
+    while (low + step < ends.size() && ends[low + step] <= position) {
+        low += step;
+        step *= 2;
+    }
+    size_t high = std::min(ends.size(), low + step + 1);
+    return static_cast<size_t>(std::upper_bound(ends.begin() + low, ends.begin() + high, position) - ends.begin());
+}
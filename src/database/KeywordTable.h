@@ -0,0 +1,76 @@
+#ifndef KEYWORD_TABLE_H
+#define KEYWORD_TABLE_H
+
+#include "../food/Food.h"
+#include "SearchCache.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Folded keywords of every food in one contiguous buffer, for full-scan search
+ *
+ * The foods' folded keyword buffers are stored back to back in catalog (ID) order, so a
+ * search term is found in every food with one vectorized scan of the buffer instead of
+ * one substring search per food. The table is rebuilt on the first search after the
+ * catalog changes.
+ */
+class KeywordTable {
+public:
+    using FoodMap = std::map<std::string, std::shared_ptr<Food>, std::less<>>;
+
+    /**
+     * @brief Mark the table out of date; call whenever foods or their keywords change
+     */
+    void invalidate();
+
+    /**
+     * @brief Find the foods whose keywords contain the search terms
+     *
+     * Safe to call from several threads at once, as long as the catalog does not change
+     * meanwhile.
+     * @param foods The catalog, used to rebuild the table if it is out of date
+     * @param terms Lowercase, deduplicated search terms
+     * @param mode Whether a food needs all terms or any of them
+     * @return The matching foods in ID order; every food if there are no terms
+     */
+    std::vector<std::shared_ptr<Food>> findMatching(const FoodMap& foods, const std::vector<std::string>& terms,
+                                                    SearchCache::MatchMode mode) const;
+
+private:
+    /**
+     * @brief Rebuild the table from the catalog if it is out of date
+     * @param foods The catalog
+     */
+    void refresh(const FoodMap& foods) const;
+
+    /**
+     * @brief Advance the match count of every food containing a term
+     * @param term The lowercase term
+     * @param matched Match count per food
+     * @param required Only foods at this count advance, to count each food once per term
+     * @return Number of foods advanced
+     */
+    size_t markTerm(const std::string& term, std::vector<uint32_t>& matched, uint32_t required) const;
+
+    /**
+     * @brief Find the food whose keywords hold a buffer position
+     * @param position Offset into text
+     * @param from Index of a food at or before the one holding the position
+     * @return Index of the food
+     */
+    size_t foodAt(size_t position, size_t from) const;
+
+    mutable std::atomic<bool> stale{true};
+    mutable std::mutex rebuildMutex;                    // One rebuild at a time
+    mutable std::string text;                           // Folded keywords of all foods, back to back
+    mutable std::vector<size_t> ends;                   // End of each food's keywords in text
+    mutable std::vector<std::shared_ptr<Food>> entries; // Foods in the same order
+};
+
+#endif // KEYWORD_TABLE_H
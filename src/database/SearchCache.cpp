@@ -0,0 +1,93 @@
+#include "SearchCache.h"
+#include <algorithm>
+
+SearchCache::SearchCache(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+SearchCache::Query SearchCache::normalize(const std::vector<std::string>& keywords, MatchMode mode) {
+    Query query{mode, keywords};
+
+    // Matching is case-insensitive and order-independent, so fold case and sort
+    for (auto& term : query.terms) {
+        std::transform(term.begin(), term.end(), term.begin(), ::tolower);
+    }
+    std::sort(query.terms.begin(), query.terms.end());
+    query.terms.erase(std::unique(query.terms.begin(), query.terms.end()), query.terms.end());
+
+    return query;
+}
+
+std::string SearchCache::makeKey(const Query& query) {
+    std::string key(1, query.mode == MatchMode::ALL ? 'A' : 'a');
+    for (const auto& term : query.terms) {
+        key += '\x1f'; // Unit separator cannot appear in keywords typed at the prompt
+        key += term;
+    }
+    return key;
+}
+
+bool SearchCache::lookup(const Query& query, std::vector<std::shared_ptr<Food>>& result) {
+    std::string key = makeKey(query);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++stats.misses;
+        return false;
+    }
+
+    // Move the entry to the front of the LRU list
+    entries.splice(entries.begin(), entries, it->second);
+    result = it->second->result;
+    ++stats.hits;
+    return true;
+}
+
+void SearchCache::store(const Query& query, const std::vector<std::shared_ptr<Food>>& result) {
+    std::string key = makeKey(query);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        it->second->result = result;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+        ++stats.evictions;
+    }
+
+    entries.push_front(Entry{key, query, result});
+    index[key] = entries.begin();
+}
+
+void SearchCache::invalidateMatching(const Food& food) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end();) {
+        bool matches = it->query.mode == MatchMode::ALL
+            ? food.matchesAllFoldedKeywords(it->query.terms)
+            : food.matchesAnyFoldedKeyword(it->query.terms);
+
+        if (matches) {
+            index.erase(it->key);
+            it = entries.erase(it);
+            ++stats.invalidations;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SearchCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+}
+
+SearchCacheStats SearchCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    SearchCacheStats result = stats;
+    result.entries = entries.size();
+    return result;
+}
@@ -0,0 +1,112 @@
+#ifndef SEARCH_CACHE_H
+#define SEARCH_CACHE_H
+
+#include "../food/Food.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Counters describing how well the search cache performs
+ */
+struct SearchCacheStats {
+    size_t hits = 0;          // Searches answered from the cache
+    size_t misses = 0;        // Searches that needed a full scan
+    size_t invalidations = 0; // Entries dropped because a new food could match them
+    size_t evictions = 0;     // Entries dropped to stay within capacity
+    size_t entries = 0;       // Entries currently cached
+};
+
+/**
+ * @brief LRU cache of keyword search results keyed by the normalized query
+ *
+ * Queries are normalized to lowercased, deduplicated and sorted terms plus the match
+ * mode, so "Fruit,sweet" and "sweet,fruit,FRUIT" share one entry. All members are
+ * guarded by a mutex because tenants searching the shared database run concurrently.
+ */
+class SearchCache {
+public:
+    /**
+     * @brief How the search terms are combined
+     */
+    enum class MatchMode { ANY, ALL };
+
+    /**
+     * @brief Normalized form of a search query
+     */
+    struct Query {
+        MatchMode mode;
+        std::vector<std::string> terms;
+    };
+
+    /**
+     * @brief Constructor for SearchCache
+     * @param capacity Maximum number of cached queries
+     */
+    explicit SearchCache(size_t capacity = 128);
+
+    /**
+     * @brief Normalize search keywords into a cache query
+     * @param keywords The keywords as entered by the user
+     * @param mode How the keywords are combined
+     * @return The normalized query
+     */
+    static Query normalize(const std::vector<std::string>& keywords, MatchMode mode);
+
+    /**
+     * @brief Look up the results of a query
+     * @param query The normalized query
+     * @param result Filled with the cached results on a hit
+     * @return true on a cache hit, false otherwise
+     */
+    bool lookup(const Query& query, std::vector<std::shared_ptr<Food>>& result);
+
+    /**
+     * @brief Store the results of a query, evicting the least recently used entry if full
+     * @param query The normalized query
+     * @param result The results to cache
+     */
+    void store(const Query& query, const std::vector<std::shared_ptr<Food>>& result);
+
+    /**
+     * @brief Drop every cached query that the given food would match
+     * @param food A food that was just added to the database
+     */
+    void invalidateMatching(const Food& food);
+
+    /**
+     * @brief Drop all cached queries
+     */
+    void clear();
+
+    /**
+     * @brief Get the cache counters
+     * @return Current statistics
+     */
+    SearchCacheStats getStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        Query query;
+        std::vector<std::shared_ptr<Food>> result;
+    };
+
+    size_t capacity;                // Maximum number of entries
+    std::list<Entry> entries;       // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index; // Key to entry
+    SearchCacheStats stats;         // Hit, miss and invalidation counters
+    mutable std::mutex mutex;       // Guards entries, index and stats
+
+    /**
+     * @brief Build the lookup key for a normalized query
+     * @param query The normalized query
+     * @return Unique key string
+     */
+    static std::string makeKey(const Query& query);
+};
+
+#endif // SEARCH_CACHE_H
@@ -0,0 +1,382 @@
+#include "TagBitmap.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+size_t popcount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_popcountll(word));
+#else
+    size_t count = 0;
+    while (word) {
+        word &= word - 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// Index of the lowest set bit; word must be non-zero
+size_t lowestBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_ctzll(word));
+#else
+    size_t bit = 0;
+    while (!((word >> bit) & 1)) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+size_t countBits(const std::vector<uint64_t>& words) {
+    size_t count = 0;
+    for (uint64_t word : words) {
+        count += popcount(word);
+    }
+    return count;
+}
+
+// Copy of a container's bits as a bitset, whatever its representation
+std::vector<uint64_t> asBitset(const std::vector<uint16_t>& array, const std::vector<uint64_t>& bitset,
+                               size_t words) {
+    if (!bitset.empty()) {
+        return bitset;
+    }
+    std::vector<uint64_t> result(words, 0);
+    for (uint16_t low : array) {
+        result[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+    return result;
+}
+
+} // namespace
+
+bool TagBitmap::Container::contains(uint16_t low) const {
+    if (isBitset()) {
+        return (bitset[low >> 6] >> (low & 63)) & 1;
+    }
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+void TagBitmap::Container::toBitset() {
+    if (isBitset()) {
+        return;
+    }
+    bitset = asBitset(array, bitset, BITSET_WORDS);
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void TagBitmap::Container::normalize() {
+    if (isBitset() && cardinality <= ARRAY_LIMIT) {
+        // Dense chunk became sparse, convert back to a sorted array
+        array.clear();
+        array.reserve(cardinality);
+        for (size_t w = 0; w < bitset.size(); ++w) {
+            uint64_t word = bitset[w];
+            while (word) {
+                array.push_back(static_cast<uint16_t>(w * 64 + lowestBit(word)));
+                word &= word - 1;
+            }
+        }
+        bitset.clear();
+        bitset.shrink_to_fit();
+    } else if (!isBitset() && cardinality > ARRAY_LIMIT) {
+        toBitset();
+    }
+}
+
+const TagBitmap::Container* TagBitmap::findContainer(uint16_t key) const {
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container& c, uint16_t k) { return c.key < k; });
+    if (it != containers.end() && it->key == key) {
+        return &*it;
+    }
+    return nullptr;
+}
+
+void TagBitmap::add(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+    // Slots are handed out in ascending order, so the last chunk is the usual target
+    std::vector<Container>::iterator it;
+    if (!containers.empty() && containers.back().key == key) {
+        it = containers.end() - 1;
+    } else {
+        it = std::lower_bound(containers.begin(), containers.end(), key,
+                              [](const Container& c, uint16_t k) { return c.key < k; });
+        if (it == containers.end() || it->key != key) {
+            Container container;
+            container.key = key;
+            it = containers.insert(it, container);
+        }
+    }
+
+    Container& container = *it;
+    if (container.isBitset()) {
+        uint64_t mask = uint64_t(1) << (low & 63);
+        if (!(container.bitset[low >> 6] & mask)) {
+            container.bitset[low >> 6] |= mask;
+            ++container.cardinality;
+        }
+        return;
+    }
+
+    if (container.array.empty() || container.array.back() < low) {
+        container.array.push_back(low);
+    } else {
+        auto pos = std::lower_bound(container.array.begin(), container.array.end(), low);
+        if (pos != container.array.end() && *pos == low) {
+            return;
+        }
+        container.array.insert(pos, low);
+    }
+    ++container.cardinality;
+    container.normalize();
+}
+
+void TagBitmap::remove(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container& c, uint16_t k) { return c.key < k; });
+    if (it == containers.end() || it->key != key || !it->contains(low)) {
+        return;
+    }
+
+    if (it->isBitset()) {
+        it->bitset[low >> 6] &= ~(uint64_t(1) << (low & 63));
+    } else {
+        it->array.erase(std::lower_bound(it->array.begin(), it->array.end(), low));
+    }
+    --it->cardinality;
+
+    if (it->cardinality == 0) {
+        containers.erase(it);
+    } else {
+        it->normalize();
+    }
+}
+
+bool TagBitmap::contains(uint32_t value) const {
+    const Container* container = findContainer(static_cast<uint16_t>(value >> 16));
+    return container && container->contains(static_cast<uint16_t>(value & 0xFFFF));
+}
+
+size_t TagBitmap::cardinality() const {
+    size_t total = 0;
+    for (const auto& container : containers) {
+        total += container.cardinality;
+    }
+    return total;
+}
+
+bool TagBitmap::empty() const {
+    return containers.empty();
+}
+
+std::vector<uint32_t> TagBitmap::toVector() const {
+    std::vector<uint32_t> values;
+    values.reserve(cardinality());
+
+    for (const auto& container : containers) {
+        uint32_t high = uint32_t(container.key) << 16;
+        if (container.isBitset()) {
+            for (size_t w = 0; w < container.bitset.size(); ++w) {
+                uint64_t word = container.bitset[w];
+                while (word) {
+                    values.push_back(high | static_cast<uint32_t>(w * 64 + lowestBit(word)));
+                    word &= word - 1;
+                }
+            }
+        } else {
+            for (uint16_t low : container.array) {
+                values.push_back(high | low);
+            }
+        }
+    }
+
+    return values;
+}
+
+TagBitmap TagBitmap::range(uint32_t count) {
+    TagBitmap result;
+
+    for (uint32_t start = 0; start < count; start += 65536) {
+        Container container;
+        container.key = static_cast<uint16_t>(start >> 16);
+        container.cardinality = std::min<uint32_t>(count - start, 65536);
+        container.bitset.assign(BITSET_WORDS, 0);
+
+        size_t fullWords = container.cardinality / 64;
+        std::fill(container.bitset.begin(), container.bitset.begin() + fullWords, ~uint64_t(0));
+        if (container.cardinality % 64) {
+            container.bitset[fullWords] = (uint64_t(1) << (container.cardinality % 64)) - 1;
+        }
+
+        container.normalize();
+        result.containers.push_back(std::move(container));
+    }
+
+    return result;
+}
+
+TagBitmap::Container TagBitmap::intersectContainers(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+
+    if (!a.isBitset() && !b.isBitset()) {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(result.array));
+        result.cardinality = result.array.size();
+    } else if (!a.isBitset() || !b.isBitset()) {
+        // Probe the bitset with each member of the array
+        const Container& sparse = a.isBitset() ? b : a;
+        const Container& dense = a.isBitset() ? a : b;
+        for (uint16_t low : sparse.array) {
+            if (dense.contains(low)) {
+                result.array.push_back(low);
+            }
+        }
+        result.cardinality = result.array.size();
+    } else {
+        result.bitset.resize(BITSET_WORDS);
+        for (size_t w = 0; w < BITSET_WORDS; ++w) {
+            result.bitset[w] = a.bitset[w] & b.bitset[w];
+        }
+        result.cardinality = countBits(result.bitset);
+        result.normalize();
+    }
+
+    return result;
+}
+
+TagBitmap::Container TagBitmap::uniteContainers(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+
+    if (!a.isBitset() && !b.isBitset() && a.cardinality + b.cardinality <= ARRAY_LIMIT) {
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(result.array));
+        result.cardinality = result.array.size();
+        return result;
+    }
+
+    result.bitset = asBitset(a.array, a.bitset, BITSET_WORDS);
+    if (b.isBitset()) {
+        for (size_t w = 0; w < BITSET_WORDS; ++w) {
+            result.bitset[w] |= b.bitset[w];
+        }
+    } else {
+        for (uint16_t low : b.array) {
+            result.bitset[low >> 6] |= uint64_t(1) << (low & 63);
+        }
+    }
+    result.cardinality = countBits(result.bitset);
+    result.normalize();
+
+    return result;
+}
+
+TagBitmap::Container TagBitmap::subtractContainers(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+
+    if (!a.isBitset()) {
+        if (b.isBitset()) {
+            for (uint16_t low : a.array) {
+                if (!b.contains(low)) {
+                    result.array.push_back(low);
+                }
+            }
+        } else {
+            std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                                std::back_inserter(result.array));
+        }
+        result.cardinality = result.array.size();
+        return result;
+    }
+
+    result.bitset = a.bitset;
+    if (b.isBitset()) {
+        for (size_t w = 0; w < BITSET_WORDS; ++w) {
+            result.bitset[w] &= ~b.bitset[w];
+        }
+    } else {
+        for (uint16_t low : b.array) {
+            result.bitset[low >> 6] &= ~(uint64_t(1) << (low & 63));
+        }
+    }
+    result.cardinality = countBits(result.bitset);
+    result.normalize();
+
+    return result;
+}
+
+TagBitmap TagBitmap::intersect(const TagBitmap& a, const TagBitmap& b) {
+    TagBitmap result;
+    auto ia = a.containers.begin();
+    auto ib = b.containers.begin();
+
+    while (ia != a.containers.end() && ib != b.containers.end()) {
+        if (ia->key < ib->key) {
+            ++ia;
+        } else if (ib->key < ia->key) {
+            ++ib;
+        } else {
+            Container container = intersectContainers(*ia, *ib);
+            if (container.cardinality > 0) {
+                result.containers.push_back(std::move(container));
+            }
+            ++ia;
+            ++ib;
+        }
+    }
+
+    return result;
+}
+
+TagBitmap TagBitmap::unite(const TagBitmap& a, const TagBitmap& b) {
+    TagBitmap result;
+    auto ia = a.containers.begin();
+    auto ib = b.containers.begin();
+
+    while (ia != a.containers.end() || ib != b.containers.end()) {
+        if (ib == b.containers.end() || (ia != a.containers.end() && ia->key < ib->key)) {
+            result.containers.push_back(*ia++);
+        } else if (ia == a.containers.end() || ib->key < ia->key) {
+            result.containers.push_back(*ib++);
+        } else {
+            result.containers.push_back(uniteContainers(*ia, *ib));
+            ++ia;
+            ++ib;
+        }
+    }
+
+    return result;
+}
+
+TagBitmap TagBitmap::subtract(const TagBitmap& a, const TagBitmap& b) {
+    TagBitmap result;
+    auto ib = b.containers.begin();
+
+    for (const auto& container : a.containers) {
+        while (ib != b.containers.end() && ib->key < container.key) {
+            ++ib;
+        }
+        if (ib == b.containers.end() || ib->key != container.key) {
+            result.containers.push_back(container);
+            continue;
+        }
+        Container difference = subtractContainers(container, *ib);
+        if (difference.cardinality > 0) {
+            result.containers.push_back(std::move(difference));
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,106 @@
+#ifndef TAG_BITMAP_H
+#define TAG_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Compressed bitmap of food slots, organized like a roaring bitmap
+ *
+ * Values are split into 2^16-sized chunks keyed by their upper 16 bits. Sparse chunks
+ * store their lower 16 bits in a sorted array; chunks with more than 4096 members switch
+ * to a 65536-bit bitset. Set operations work chunk by chunk on the cheapest representation.
+ */
+class TagBitmap {
+public:
+    /**
+     * @brief Add a value to the bitmap (fastest when values arrive in ascending order)
+     * @param value The value to add
+     */
+    void add(uint32_t value);
+
+    /**
+     * @brief Remove a value from the bitmap
+     * @param value The value to remove
+     */
+    void remove(uint32_t value);
+
+    /**
+     * @brief Check whether a value is in the bitmap
+     * @param value The value to check
+     * @return true if present, false otherwise
+     */
+    bool contains(uint32_t value) const;
+
+    /**
+     * @brief Get the number of values in the bitmap
+     * @return Cardinality
+     */
+    size_t cardinality() const;
+
+    /**
+     * @brief Check whether the bitmap is empty
+     * @return true if there are no values
+     */
+    bool empty() const;
+
+    /**
+     * @brief Get all values in ascending order
+     * @return Vector of values
+     */
+    std::vector<uint32_t> toVector() const;
+
+    /**
+     * @brief Create a bitmap holding every value in [0, count)
+     * @param count Number of values
+     * @return The filled bitmap
+     */
+    static TagBitmap range(uint32_t count);
+
+    /**
+     * @brief Intersect two bitmaps (AND)
+     */
+    static TagBitmap intersect(const TagBitmap& a, const TagBitmap& b);
+
+    /**
+     * @brief Unite two bitmaps (OR)
+     */
+    static TagBitmap unite(const TagBitmap& a, const TagBitmap& b);
+
+    /**
+     * @brief Subtract one bitmap from another (a AND NOT b)
+     */
+    static TagBitmap subtract(const TagBitmap& a, const TagBitmap& b);
+
+private:
+    static const size_t ARRAY_LIMIT = 4096;  // Largest chunk stored as a sorted array
+    static const size_t BITSET_WORDS = 1024; // 65536 bits per bitset chunk
+
+    struct Container {
+        uint16_t key = 0;                // Upper 16 bits shared by all values in the chunk
+        std::vector<uint16_t> array;     // Sorted lower bits when the chunk is sparse
+        std::vector<uint64_t> bitset;    // Bitset of lower bits when the chunk is dense
+        size_t cardinality = 0;          // Number of values in the chunk
+
+        bool isBitset() const { return !bitset.empty(); }
+        bool contains(uint16_t low) const;
+        void toBitset();
+        void normalize();
+    };
+
+    std::vector<Container> containers; // Chunks sorted by key
+
+    /**
+     * @brief Find the chunk for a key
+     * @param key Upper 16 bits of a value
+     * @return Pointer to the chunk, or nullptr if absent
+     */
+    const Container* findContainer(uint16_t key) const;
+
+    static Container intersectContainers(const Container& a, const Container& b);
+    static Container uniteContainers(const Container& a, const Container& b);
+    static Container subtractContainers(const Container& a, const Container& b);
+};
+
+#endif // TAG_BITMAP_H
@@ -0,0 +1,89 @@
+#include "TagIndex.h"
+#include <algorithm>
+
+void TagIndex::clear() {
+    slots.clear();
+    tagBitmaps.clear();
+    slotIds.clear();
+    sortedById = true;
+}
+
+uint32_t TagIndex::add(const std::shared_ptr<Food>& food) {
+    uint32_t slot = static_cast<uint32_t>(slots.size());
+    const std::string id = food->getId();
+    if (!slots.empty() && id < slots.back()->getId()) {
+        sortedById = false;
+    }
+    slots.push_back(food);
+    slotIds[id] = slot;
+    tagSlot(*food, slot, true);
+    return slot;
+}
+
+bool TagIndex::remove(const std::string& id) {
+    auto it = slotIds.find(id);
+    if (it == slotIds.end()) {
+        return false;
+    }
+    uint32_t slot = it->second;
+    uint32_t last = static_cast<uint32_t>(slots.size() - 1);
+    slotIds.erase(it);
+
+    tagSlot(*slots[slot], slot, false);
+    if (slot != last) {
+        // Move the last food into the hole rather than renumbering everything after it
+        std::shared_ptr<Food> moved = slots[last];
+        tagSlot(*moved, last, false);
+        tagSlot(*moved, slot, true);
+        slots[slot] = moved;
+        slotIds[moved->getId()] = slot;
+        sortedById = false;
+    }
+    slots.pop_back();
+    return true;
+}
+
+void TagIndex::tagSlot(const Food& food, uint32_t slot, bool present) {
+    food.forEachFoldedKeyword([&](std::string_view keyword) {
+        if (present) {
+            tagBitmaps[std::string(keyword)].add(slot);
+            return;
+        }
+        auto it = tagBitmaps.find(std::string(keyword));
+        if (it != tagBitmaps.end()) {
+            it->second.remove(slot);
+            if (it->second.empty()) {
+                tagBitmaps.erase(it);
+            }
+        }
+    });
+}
+
+const TagBitmap* TagIndex::find(const std::string& tag) const {
+    auto it = tagBitmaps.find(tag);
+    if (it != tagBitmaps.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+bool TagIndex::findSlot(const std::string& id, uint32_t& slot) const {
+    auto it = slotIds.find(id);
+    if (it == slotIds.end()) {
+        return false;
+    }
+    slot = it->second;
+    return true;
+}
+
+size_t TagIndex::size() const {
+    return slots.size();
+}
+
+const std::shared_ptr<Food>& TagIndex::foodAt(uint32_t slot) const {
+    return slots[slot];
+}
+
+bool TagIndex::isSortedById() const {
+    return sortedById;
+}
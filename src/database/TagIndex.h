@@ -0,0 +1,90 @@
+#ifndef TAG_INDEX_H
+#define TAG_INDEX_H
+
+#include "../food/Food.h"
+#include "TagBitmap.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Inverted index from exact (lowercased) keywords to bitmaps of food slots
+ *
+ * Every indexed food gets a dense slot number; each keyword maps to the bitmap of
+ * slots whose food carries that keyword.
+ */
+class TagIndex {
+public:
+    /**
+     * @brief Remove all foods from the index
+     */
+    void clear();
+
+    /**
+     * @brief Index a food under its keywords
+     * @param food The food to index
+     * @return The slot assigned to the food
+     */
+    uint32_t add(const std::shared_ptr<Food>& food);
+
+    /**
+     * @brief Remove a food from the index
+     *
+     * The last slot moves into the freed one, so slots stay dense. Call this before
+     * changing the food's keywords.
+     * @param id The ID of the food
+     * @return true if the food was indexed, false otherwise
+     */
+    bool remove(const std::string& id);
+
+    /**
+     * @brief Get the bitmap of foods carrying a keyword
+     * @param tag Lowercased keyword
+     * @return Pointer to the bitmap, or nullptr if no food carries the keyword
+     */
+    const TagBitmap* find(const std::string& tag) const;
+
+    /**
+     * @brief Get the slot of a food
+     * @param id The ID of the food
+     * @param slot Set to the food's slot if found
+     * @return true if the food is indexed, false otherwise
+     */
+    bool findSlot(const std::string& id, uint32_t& slot) const;
+
+    /**
+     * @brief Get the number of indexed foods
+     * @return Number of slots in use
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the food stored in a slot
+     * @param slot The slot number
+     * @return Shared pointer to the food
+     */
+    const std::shared_ptr<Food>& foodAt(uint32_t slot) const;
+
+    /**
+     * @brief Check whether slot order matches food ID order
+     * @return true if foods were indexed in ascending ID order
+     */
+    bool isSortedById() const;
+
+private:
+    /**
+     * @brief Set or clear a slot in the bitmaps of a food's keywords
+     * @param food The food whose keywords to use
+     * @param slot The slot number
+     * @param present Whether to set or clear the slot
+     */
+    void tagSlot(const Food& food, uint32_t slot, bool present);
+
+    std::vector<std::shared_ptr<Food>> slots;              // Slot number to food
+    std::unordered_map<std::string, TagBitmap> tagBitmaps; // Lowercased keyword to slots
+    std::unordered_map<std::string, uint32_t> slotIds;     // Food ID to slot
+    bool sortedById = true;                                // Whether slots are in ID order
+};
+
+#endif // TAG_INDEX_H
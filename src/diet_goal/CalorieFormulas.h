@@ -0,0 +1,112 @@
+#ifndef CALORIE_FORMULAS_H
+#define CALORIE_FORMULAS_H
+
+#include "DietGoalProfile.h"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+// Each formula is a policy: a title and the base (resting) calories it computes. Adding a
+// formula means writing its policy and adding it to the CalorieFormulas registry below.
+
+struct HarrisBenedictFormula {
+    static constexpr const char* title = "Harris-Benedict";
+
+    static constexpr double baseCalories(Gender gender, double weight, double height, int age) {
+        return (gender == Gender::MALE)
+            ? 88.362 + (13.397 * weight) + (4.799 * height) - (5.677 * age)
+            : 447.593 + (9.247 * weight) + (3.098 * height) - (4.330 * age);
+    }
+};
+
+struct MifflinStJeorFormula {
+    static constexpr const char* title = "Mifflin-St Jeor";
+
+    static constexpr double baseCalories(Gender gender, double weight, double height, int age) {
+        return (gender == Gender::MALE)
+            ? (10 * weight) + (6.25 * height) - (5 * age) + 5
+            : (10 * weight) + (6.25 * height) - (5 * age) - 161;
+    }
+};
+
+/**
+ * @brief Compile-time registry of calorie formulas and activity multipliers
+ *
+ * A formula chosen at run time by index is dispatched through a chain of comparisons the
+ * compiler can see through, so every formula inlines into the caller; code that knows its
+ * formula can name the policy directly.
+ */
+template <typename... Formulas>
+struct CalorieFormulaRegistry {
+    static constexpr int COUNT = static_cast<int>(sizeof...(Formulas));
+
+    // Titles in registry order; index 0 is method 1 in the profile file and menus
+    static constexpr const char* titles[] = {Formulas::title...};
+
+    // Indexed by ActivityLevel, SEDENTARY to EXTRA_ACTIVE
+    static constexpr double activityMultipliers[] = {1.2, 1.375, 1.55, 1.725, 1.9};
+
+    /**
+     * @brief Get the multiplier of an activity level; UNDEFINED counts as sedentary
+     */
+    static constexpr double activityMultiplier(ActivityLevel level) {
+        return level >= ActivityLevel::SEDENTARY && level <= ActivityLevel::EXTRA_ACTIVE
+            ? activityMultipliers[static_cast<int>(level)]
+            : activityMultipliers[0];
+    }
+
+    /**
+     * @brief Call visitor with a value of the formula policy at an index
+     *
+     * CalorieTargetBatch's SIMD kernel evaluates every formula and masks by index instead of
+     * calling this; it relies on unknown indexes failing here and checks its lanes to match.
+     * @return What the visitor returns
+     * @throws std::out_of_range if no formula has that index
+     */
+    template <typename Visitor>
+    static constexpr auto visit(int index, Visitor&& visitor) {
+        return visitAt(index, std::forward<Visitor>(visitor), std::index_sequence_for<Formulas...>{});
+    }
+
+    /**
+     * @brief Compute base calories with the formula at an index
+     */
+    static constexpr double baseCalories(int index, Gender gender, double weight, double height, int age) {
+        return visit(index, [&](auto formula) {
+            return decltype(formula)::baseCalories(gender, weight, height, age);
+        });
+    }
+
+    /**
+     * @brief Compute target calories: base calories times the activity multiplier
+     */
+    template <typename Formula>
+    static constexpr double targetCalories(Gender gender, double weight, double height, int age,
+                                           ActivityLevel level) {
+        return Formula::baseCalories(gender, weight, height, age) * activityMultiplier(level);
+    }
+
+    static constexpr double targetCalories(int index, Gender gender, double weight, double height, int age,
+                                           ActivityLevel level) {
+        return baseCalories(index, gender, weight, height, age) * activityMultiplier(level);
+    }
+
+private:
+    template <typename Visitor, std::size_t... Indexes>
+    static constexpr auto visitAt(int index, Visitor&& visitor, std::index_sequence<Indexes...>) {
+        using Result = decltype(visitor(std::tuple_element_t<0, std::tuple<Formulas...>>{}));
+        Result result{};
+        // Short-circuits at the matching index
+        bool found = ((index == static_cast<int>(Indexes) ? (result = visitor(Formulas{}), true) : false) || ...);
+        if (!found) {
+            throw std::out_of_range("Unknown calorie formula index " + std::to_string(index));
+        }
+        return result;
+    }
+};
+
+using CalorieFormulas = CalorieFormulaRegistry<HarrisBenedictFormula, MifflinStJeorFormula>;
+
+#endif // CALORIE_FORMULAS_H
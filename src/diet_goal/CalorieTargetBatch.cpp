@@ -0,0 +1,126 @@
+#include "CalorieTargetBatch.h"
+#include "CalorieFormulas.h"
+#include "utils/Tracer.h"
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The SIMD kernel spells out each formula; a new formula must be added there too
+static_assert(CalorieFormulas::COUNT == 2, "CalorieTargetBatch handles Harris-Benedict and Mifflin-St Jeor only");
+
+void ProfileColumns::add(Gender gender, double weight, double height, int age, ActivityLevel activityLevel,
+                         int method) {
+    genders.push_back(gender);
+    weights.push_back(weight);
+    heights.push_back(height);
+    ages.push_back(age);
+    activityLevels.push_back(activityLevel);
+    methods.push_back(method);
+}
+
+void ProfileColumns::reserve(size_t count) {
+    genders.reserve(count);
+    weights.reserve(count);
+    heights.reserve(count);
+    ages.reserve(count);
+    activityLevels.reserve(count);
+    methods.reserve(count);
+}
+
+double CalorieTargetBatch::calculateOne(const ProfileColumns& profiles, size_t index) {
+    return CalorieFormulas::targetCalories(profiles.methods[index] - 1, profiles.genders[index],
+                                           profiles.weights[index], profiles.heights[index], profiles.ages[index],
+                                           profiles.activityLevels[index]);
+}
+
+void CalorieTargetBatch::calculateScalar(const ProfileColumns& profiles, size_t begin, size_t end,
+                                         double* targets) {
+    for (size_t i = begin; i < end; ++i) {
+        targets[i] = calculateOne(profiles, i);
+    }
+}
+
+#if defined(__SSE2__)
+namespace {
+
+inline __m128d blend(__m128d mask, __m128d ifSet, __m128d ifClear) {
+    return _mm_or_pd(_mm_and_pd(mask, ifSet), _mm_andnot_pd(mask, ifClear));
+}
+
+// Widen the comparison results of two ints into two double-lane masks
+inline __m128d laneMask(__m128i mask32) {
+    return _mm_castsi128_pd(_mm_shuffle_epi32(mask32, _MM_SHUFFLE(1, 1, 0, 0)));
+}
+
+inline __m128i loadTwoInts(const void* values) {
+    return _mm_loadl_epi64(static_cast<const __m128i*>(values));
+}
+
+} // namespace
+#endif
+
+void CalorieTargetBatch::calculate(const ProfileColumns& profiles, double* targets) {
+    TRACE_SCOPE("CalorieTargetBatch::calculate");
+    size_t count = profiles.size();
+    if (profiles.genders.size() != count || profiles.heights.size() != count || profiles.ages.size() != count ||
+        profiles.activityLevels.size() != count || profiles.methods.size() != count) {
+        throw std::invalid_argument("Profile columns must all have the same length");
+    }
+
+    size_t i = 0;
+#if defined(__SSE2__)
+    static_assert(sizeof(Gender) == sizeof(int) && sizeof(ActivityLevel) == sizeof(int),
+                  "Enum columns are loaded as 32-bit ints");
+
+    // Both formulas are evaluated for every lane with the operations of the scalar code in
+    // the same order, then the lane's method picks one. Gender only changes constants, so it
+    // selects coefficients; "x - 161" equals "x + -161" exactly in IEEE arithmetic.
+    const __m128i male = _mm_set1_epi32(static_cast<int>(Gender::MALE));
+    const __m128i harrisBenedict = _mm_set1_epi32(1);
+    const __m128i mifflinStJeor = _mm_set1_epi32(2);
+    __m128i allKnown = _mm_set1_epi32(-1); // Lanes whose methods were all known so far
+    for (; i + 2 <= count; i += 2) {
+        __m128d weight = _mm_loadu_pd(&profiles.weights[i]);
+        __m128d height = _mm_loadu_pd(&profiles.heights[i]);
+        __m128d age = _mm_cvtepi32_pd(loadTwoInts(&profiles.ages[i]));
+        __m128i gender = loadTwoInts(&profiles.genders[i]);
+        __m128i method = loadTwoInts(&profiles.methods[i]);
+        __m128d isMale = laneMask(_mm_cmpeq_epi32(gender, male));
+
+        __m128d harrisBenedictBase = _mm_sub_pd(
+            _mm_add_pd(_mm_add_pd(blend(isMale, _mm_set1_pd(88.362), _mm_set1_pd(447.593)),
+                                  _mm_mul_pd(blend(isMale, _mm_set1_pd(13.397), _mm_set1_pd(9.247)), weight)),
+                       _mm_mul_pd(blend(isMale, _mm_set1_pd(4.799), _mm_set1_pd(3.098)), height)),
+            _mm_mul_pd(blend(isMale, _mm_set1_pd(5.677), _mm_set1_pd(4.330)), age));
+
+        __m128d mifflinStJeorBase = _mm_add_pd(
+            _mm_sub_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(10), weight), _mm_mul_pd(_mm_set1_pd(6.25), height)),
+                       _mm_mul_pd(_mm_set1_pd(5), age)),
+            blend(isMale, _mm_set1_pd(5), _mm_set1_pd(-161)));
+
+        // The lane's method keeps one formula; unknown methods are noted and fail after the loop
+        __m128i isHarrisBenedict = _mm_cmpeq_epi32(method, harrisBenedict);
+        __m128i isMifflinStJeor = _mm_cmpeq_epi32(method, mifflinStJeor);
+        allKnown = _mm_and_si128(allKnown, _mm_or_si128(isHarrisBenedict, isMifflinStJeor));
+        __m128d base = _mm_or_pd(_mm_and_pd(laneMask(isHarrisBenedict), harrisBenedictBase),
+                                 _mm_and_pd(laneMask(isMifflinStJeor), mifflinStJeorBase));
+
+        __m128d multiplier = _mm_set_pd(CalorieFormulas::activityMultiplier(profiles.activityLevels[i + 1]),
+                                        CalorieFormulas::activityMultiplier(profiles.activityLevels[i]));
+        _mm_storeu_pd(targets + i, _mm_mul_pd(base, multiplier));
+    }
+    // Only the low two lanes hold methods; fail like the scalar registry lookup would
+    if ((_mm_movemask_epi8(allKnown) & 0xff) != 0xff) {
+        throw std::out_of_range("Unknown calorie calculation method");
+    }
+#endif
+    calculateScalar(profiles, i, count, targets);
+}
+
+std::vector<double> CalorieTargetBatch::calculate(const ProfileColumns& profiles) {
+    std::vector<double> targets(profiles.size());
+    calculate(profiles, targets.data());
+    return targets;
+}
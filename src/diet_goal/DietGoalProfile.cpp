@@ -1,4 +1,10 @@
 #include "DietGoalProfile.h"
+#include "CalorieFormulas.h"
+#include "utils/DateUtils.h"
+#include "utils/FileHandler.h"
+#include "utils/Metrics.h"
+#include "utils/MemoryAccounting.h"
+#include "utils/Tracer.h"
 #include <cmath>
 #include <stdexcept>
 #include <fstream>
@@ -6,21 +12,16 @@
 #include <sstream>
 #include <ctime>
 #include <algorithm>
+#include <iterator>
 
-const std::vector<CalorieCalculationMethod> DietGoalProfile::calorieCalculationMethods = {
-    CalorieCalculationMethod("Harris-Benedict", [](Gender gender, double weight, double height, int age) {
-        double baseCalories = (gender == Gender::MALE)
-            ? 88.362 + (13.397 * weight) + (4.799 * height) - (5.677 * age)
-            : 447.593 + (9.247 * weight) + (3.098 * height) - (4.330 * age);
-        return baseCalories;
-    }),
-    CalorieCalculationMethod("Mifflin-St Jeor", [](Gender gender, double weight, double height, int age) {
-        double baseCalories = (gender == Gender::MALE)
-            ? (10 * weight) + (6.25 * height) - (5 * age) + 5
-            : (10 * weight) + (6.25 * height) - (5 * age) - 161;
-        return baseCalories;
-    })
-};
+// One method per formula in the registry, in the same order
+const std::vector<CalorieCalculationMethod> DietGoalProfile::calorieCalculationMethods = [] {
+    std::vector<CalorieCalculationMethod> methods;
+    for (int i = 0; i < CalorieFormulas::COUNT; ++i) {
+        methods.emplace_back(CalorieFormulas::titles[i], i);
+    }
+    return methods;
+}();
 
 bool DietGoalProfile::loaded() {
     return m_loaded;
@@ -83,6 +84,7 @@ void DietGoalProfile::setCalorieCalculationMethod(int idx) {
 }
 
 void DietGoalProfile::createLog() {
+    MemoryAccounting::Scope memoryScope(MemoryTag::DIET_PROFILE);
     if (!m_calculationMethod) {
         throw std::runtime_error("Cannot create log: Calorie calculation method not set");
     }
@@ -92,8 +94,20 @@ void DietGoalProfile::createLog() {
     std::strftime(dateBuffer, sizeof(dateBuffer), "%d-%m-%Y", std::localtime(&now));
     std::string date(dateBuffer);
     
-    int methodIdx = m_calculationMethod - &calorieCalculationMethods[0] + 1;
+    int methodIdx = m_calculationMethod->formulaIndex() + 1; // 1-based in the profile file
     m_logs.emplace_back(date, m_age, m_weight, m_activityLevel, methodIdx);
+    indexLog(m_logs.size() - 1);
+}
+
+void DietGoalProfile::indexLog(size_t position) {
+    int dayNumber;
+    if (!DateUtils::toDayNumber(m_logs[position].date, dayNumber)) {
+        return; // Unreadable dates can't be looked up
+    }
+    // Logs are almost always appended in date order, so this is usually a push_back
+    auto it = std::upper_bound(m_logIndex.begin(), m_logIndex.end(), dayNumber,
+                               [](int day, const LogIndexEntry& entry) { return day < entry.dayNumber; });
+    m_logIndex.insert(it, LogIndexEntry{dayNumber, position});
 }
 
 Gender DietGoalProfile::getGender() const { return m_gender; }
@@ -109,36 +123,94 @@ const CalorieCalculationMethod& DietGoalProfile::getCalorieCalculationMethod() c
 }
 
 double DietGoalProfile::calculateTargetCalories() const {
+    Metrics::Timer timer(Metrics::Id::PROFILE_TARGET);
     if (!m_calculationMethod) {
         throw std::runtime_error("Calorie calculation method not set");
     }
-    double baseCalories = m_calculationMethod->calculate(m_gender, m_weight, m_height, m_age);
-
-    // Apply activity level multiplier
-    switch (m_activityLevel) {
-        case ActivityLevel::SEDENTARY: return baseCalories * 1.2;
-        case ActivityLevel::LIGHTLY_ACTIVE: return baseCalories * 1.375;
-        case ActivityLevel::MODERATELY_ACTIVE: return baseCalories * 1.55;
-        case ActivityLevel::VERY_ACTIVE: return baseCalories * 1.725;
-        case ActivityLevel::EXTRA_ACTIVE: return baseCalories * 1.9;
-        default: return baseCalories * 1.2;
+    return CalorieFormulas::targetCalories(m_calculationMethod->formulaIndex(), m_gender, m_weight, m_height, m_age, m_activityLevel);
+}
+
+double DietGoalProfile::calculateTargetCalories(const DietProfileLog& log) const {
+    return CalorieFormulas::targetCalories(log.calorieCalculationMethodIdx - 1, m_gender, log.weight, m_height,
+                                           log.age, log.activityLevel);
+}
+
+const DietProfileLog* DietGoalProfile::getProfileOn(const std::string& date) const {
+    int dayNumber;
+    if (!DateUtils::toDayNumber(date, dayNumber)) {
+        return nullptr;
+    }
+    auto it = std::upper_bound(m_logIndex.begin(), m_logIndex.end(), dayNumber,
+                               [](int day, const LogIndexEntry& entry) { return day < entry.dayNumber; });
+    if (it == m_logIndex.begin()) {
+        return nullptr;
+    }
+    return &m_logs[std::prev(it)->position];
+}
+
+double DietGoalProfile::calculateTargetCalories(const std::string& date) const {
+    Metrics::Timer timer(Metrics::Id::PROFILE_TARGET);
+    const DietProfileLog* log = getProfileOn(date);
+    if (!log) {
+        throw std::runtime_error("No profile recorded on or before " + date);
     }
+    return calculateTargetCalories(*log);
+}
+
+bool DietGoalProfile::calculateTargetCalories(const std::string& fromDate, const std::string& toDate,
+                                              std::vector<double>& targets) const {
+    Metrics::Timer timer(Metrics::Id::PROFILE_TARGET);
+    int firstDay, lastDay;
+    if (!DateUtils::toDayNumber(fromDate, firstDay) || !DateUtils::toDayNumber(toDate, lastDay) ||
+        firstDay > lastDay) {
+        return false;
+    }
+    targets.assign(static_cast<size_t>(lastDay - firstDay) + 1, 0.0);
+
+    // One search for the first day, then walk the index: a target changes only where a log starts
+    auto next = std::upper_bound(m_logIndex.begin(), m_logIndex.end(), firstDay,
+                                 [](int day, const LogIndexEntry& entry) { return day < entry.dayNumber; });
+    double target = next == m_logIndex.begin() ? 0.0 : calculateTargetCalories(m_logs[std::prev(next)->position]);
+    for (int day = firstDay; day <= lastDay; ++day) {
+        bool changed = false;
+        while (next != m_logIndex.end() && next->dayNumber == day) {
+            ++next; // The last log of the day wins
+            changed = true;
+        }
+        if (changed) {
+            target = calculateTargetCalories(m_logs[std::prev(next)->position]);
+        }
+        targets[static_cast<size_t>(day - firstDay)] = target;
+    }
+    return true;
 }
 
 bool DietGoalProfile::saveToFile() {
-    if(!m_loaded) return true;
-    std::ofstream outFile(m_filepath);
-    if (!outFile) {
+    TRACE_SCOPE("DietGoalProfile::saveToFile");
+    std::string contents;
+    if (!serialize(contents)) return true;
+    if (!FileHandler::writeFileAtomically(m_filepath, contents)) {
         throw std::runtime_error("Failed to open file for writing: " + m_filepath);
-        return false;
     }
+    return true;
+}
+
+const std::string& DietGoalProfile::getFilePath() const {
+    return m_filepath;
+}
 
+bool DietGoalProfile::serialize(std::string& contents) const {
+    TRACE_SCOPE("DietGoalProfile::serialize");
+    Metrics::Timer timer(Metrics::Id::PROFILE_SERIALIZE);
+    MemoryAccounting::Scope memoryScope(MemoryTag::DIET_PROFILE);
+    if(!m_loaded) return false;
+    std::ostringstream outFile;
     outFile << "# User info database\n# log format: DD-MM-YYYY:age:weight:activitylevel:method\n"
             << "gender:" << (m_gender == Gender::MALE ? "M" : "F") << '\n'
             << "height:" << m_height << '\n';
 
     // Save logs
-    DietProfileLog* prevLog = nullptr;
+    const DietProfileLog* prevLog = nullptr;
     for (const auto& log : m_logs) {
         outFile << log.date << ":";
         if (!prevLog || log.age != prevLog->age) outFile << log.age;
@@ -150,10 +222,10 @@ bool DietGoalProfile::saveToFile() {
         if (!prevLog || log.calorieCalculationMethodIdx != prevLog->calorieCalculationMethodIdx) outFile << log.calorieCalculationMethodIdx;
         outFile << "\n";
 
-        prevLog = const_cast<DietProfileLog*>(&log);
+        prevLog = &log;
     }
 
-    outFile.close();
+    contents = outFile.str();
     return true;
 }
 
@@ -226,7 +298,9 @@ int DietGoalProfile::numberOfCalculationMethods() const {
 }
 
 void DietGoalProfile::loadFromFile() {
-    std::cout << "Loading diet profile..." << std::endl;
+    TRACE_SCOPE("DietGoalProfile::loadFromFile");
+    Metrics::Timer timer(Metrics::Id::PROFILE_LOAD);
+    MemoryAccounting::Scope memoryScope(MemoryTag::DIET_PROFILE);
     std::ifstream inFile(m_filepath);
     if (!inFile) {
         // Initialize the file if it doesn't exist
@@ -302,6 +376,7 @@ void DietGoalProfile::loadFromFile() {
 
         // Create and add the log entry
         m_logs.emplace_back(date, age, weight, activityLevel, methodIdx);
+        indexLog(m_logs.size() - 1);
 
         prevDate = date;
         prevAge = age;
@@ -316,13 +391,15 @@ void DietGoalProfile::loadFromFile() {
 }
 
 void DietGoalProfile::addLog(const DietProfileLog& log) {
+    MemoryAccounting::Scope memoryScope(MemoryTag::DIET_PROFILE);
     m_logs.push_back(log);
+    indexLog(m_logs.size() - 1);
 }
 
 double CalorieCalculationMethod::calculate(Gender gender, double weight, double height, int age) const {
     // Calculates base calories.
-    return m_calculationFunction(gender, weight, height, age);
+    return CalorieFormulas::baseCalories(m_formulaIndex, gender, weight, height, age);
 }
 
-CalorieCalculationMethod::CalorieCalculationMethod(std::string title, std::function<double(Gender, double, double, int)> calculationFunction)
-    : m_title(title), m_calculationFunction(calculationFunction) {}
+CalorieCalculationMethod::CalorieCalculationMethod(std::string title, int formulaIndex)
+    : m_title(title), m_formulaIndex(formulaIndex) {}
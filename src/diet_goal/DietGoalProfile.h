@@ -3,7 +3,6 @@
 
 #include <string>
 #include <vector>
-#include <functional>
 
 enum class ActivityLevel {
     SEDENTARY,
@@ -31,15 +30,16 @@ struct DietProfileLog {
 
 class CalorieCalculationMethod {
 public:
-    CalorieCalculationMethod(std::string title, std::function<double(Gender, double, double, int)> calculationFunction);
+    CalorieCalculationMethod(std::string title, int formulaIndex); // Index into CalorieFormulas
 
     double calculate(Gender gender, double weight, double height, int age) const;
 
     std::string title() const { return m_title; }
+    int formulaIndex() const { return m_formulaIndex; }
 
 private:
     std::string m_title;
-    std::function<double(Gender, double, double, int)> m_calculationFunction;
+    int m_formulaIndex;
 };
 
 class DietGoalProfile {
@@ -66,6 +66,8 @@ public:
     int numberOfCalculationMethods() const;
 
     bool saveToFile();
+    bool serialize(std::string& contents) const; // False if there is no loaded profile to write
+    const std::string& getFilePath() const;
     void loadFromFile();
     void listCalculationMethods() const;
 
@@ -73,11 +75,28 @@ public:
     double calculateTargetCalories() const;
     void addLog(const DietProfileLog& log);
 
+    // Profile history: the log in effect on a date is the latest one dated on or before it.
+    // Gender and height are not logged, so the current values are used for every date.
+    const DietProfileLog* getProfileOn(const std::string& date) const; // nullptr if none or bad date
+    double calculateTargetCalories(const std::string& date) const;     // Throws if no profile was in effect
+    // One target per day in [fromDate, toDate]; days before the first log get 0.
+    // False if a date is malformed or fromDate is after toDate
+    bool calculateTargetCalories(const std::string& fromDate, const std::string& toDate,
+                                 std::vector<double>& targets) const;
+
     void saveLogsToFile();
     void loadLogsFromFile();
 
 private:
     void createLog();  // Helper method to create a log entry with current profile data
+    void indexLog(size_t position);  // Add m_logs[position] to m_logIndex
+    double calculateTargetCalories(const DietProfileLog& log) const;
+
+    struct LogIndexEntry {
+        int dayNumber;
+        size_t position;  // Into m_logs
+    };
+
     Gender m_gender;
     double m_height;
     double m_weight;
@@ -91,6 +110,7 @@ private:
     static const std::vector<CalorieCalculationMethod> calorieCalculationMethods;
 
     std::vector<DietProfileLog> m_logs;
+    std::vector<LogIndexEntry> m_logIndex;  // Logs by date; logs of the same day keep their order
 };
 
 #endif // DIET_GOAL_PROFILE_H
\ No newline at end of file
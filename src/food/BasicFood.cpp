@@ -2,12 +2,9 @@
 #include <iostream>
 #include <sstream>
 
-BasicFood::BasicFood(const std::string& id, const std::vector<std::string>& keywords, double caloriesPerServing)
-    : Food(id, keywords), caloriesPerServing(caloriesPerServing) {}
-
-double BasicFood::getCaloriesPerServing() const {
-    return caloriesPerServing;
-}
+BasicFood::BasicFood(const std::string& id, const std::vector<std::string>& keywords, double caloriesPerServing,
+                     std::pmr::memory_resource* memory)
+    : Food(FoodKind::BASIC, id, keywords, memory), caloriesPerServing(caloriesPerServing) {}
 
 void BasicFood::setCaloriesPerServing(double calories) {
     caloriesPerServing = calories;
@@ -29,32 +26,21 @@ std::string BasicFood::toString() const {
     return ss.str();
 }
 
-std::shared_ptr<BasicFood> BasicFood::fromString(const std::string& str) {
-    std::stringstream ss(str);
-    std::string type, id, keywordStr, caloriesStr;
+std::shared_ptr<BasicFood> BasicFood::fromString(const std::string& str, const std::shared_ptr<FoodArena>& arena) {
+    std::string_view rest(str);
     
     // Parse the string: "BASIC:id:keyword1,keyword2,...:calories"
-    std::getline(ss, type, ':');
-    if (type != "BASIC") {
+    if (nextField(rest, ':') != "BASIC") {
         throw std::invalid_argument("Not a basic food entry");
     }
     
-    std::getline(ss, id, ':');
-    std::getline(ss, keywordStr, ':');
-    std::getline(ss, caloriesStr);
-    
-    // Parse keywords
-    std::vector<std::string> keywords;
-    std::stringstream keywordStream(keywordStr);
-    std::string keyword;
-    while (std::getline(keywordStream, keyword, ',')) {
-        keywords.push_back(keyword);
-    }
+    std::string id(nextField(rest, ':'));
+    std::vector<std::string> keywords = parseKeywords(nextField(rest, ':'));
     
     // Parse calories
-    double calories = std::stod(caloriesStr);
+    double calories = std::stod(std::string(rest));
     
-    return std::make_shared<BasicFood>(id, keywords, calories);
+    return FoodArena::make<BasicFood>(arena, id, keywords, calories);
 }
 
 void BasicFood::display() const {
@@ -2,6 +2,7 @@
 #define BASIC_FOOD_H
 
 #include "Food.h"
+#include "FoodArena.h"
 
 /**
  * @brief Class representing a basic food item with calories
@@ -13,14 +14,16 @@ public:
      * @param id The unique identifier for the food
      * @param keywords List of search keywords for this food
      * @param caloriesPerServing Calories per serving of this food
+     * @param memory Resource for the ID and keywords
      */
-    BasicFood(const std::string& id, const std::vector<std::string>& keywords, double caloriesPerServing);
+    BasicFood(const std::string& id, const std::vector<std::string>& keywords, double caloriesPerServing,
+              std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     
     /**
      * @brief Get calories per serving
      * @return Calories per serving
      */
-    double getCaloriesPerServing() const override;
+    double getCaloriesPerServing() const override { return caloriesPerServing; }
     
     /**
      * @brief Set calories per serving
@@ -37,9 +40,11 @@ public:
     /**
      * @brief Create a BasicFood object from a string representation
      * @param str String representation of the BasicFood
+     * @param arena Arena to create the food in, or nullptr for the heap
      * @return Shared pointer to a new BasicFood object
      */
-    static std::shared_ptr<BasicFood> fromString(const std::string& str);
+    static std::shared_ptr<BasicFood> fromString(const std::string& str,
+                                                 const std::shared_ptr<FoodArena>& arena = nullptr);
     
     /**
      * @brief Display food information
@@ -1,29 +1,50 @@
 #include "CompositeFood.h"
+#include "FoodDispatch.h"
+#include "../utils/Metrics.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
-CompositeFood::CompositeFood(const std::string& id, const std::vector<std::string>& keywords)
-    : Food(id, keywords) {}
+CompositeFood::CompositeFood(const std::string& id, const std::vector<std::string>& keywords,
+                             std::pmr::memory_resource* memory)
+    : Food(FoodKind::COMPOSITE, id, keywords, memory), components(memory) {}
 
 void CompositeFood::addComponent(std::shared_ptr<Food> food, double servings) {
-    // If the food is already a component, add the servings
-    if (components.find(food) != components.end()) {
-        components[food] += servings;
+    // Keep the components sorted by ID; if the food is already a component, add the servings
+    std::string_view id = food->getIdView();
+    auto position = std::lower_bound(components.begin(), components.end(), id,
+                                     [](const Component& component, std::string_view key) {
+                                         return component.food->getIdView() < key;
+                                     });
+    if (position != components.end() && position->food->getIdView() == id) {
+        position->servings += servings;
     } else {
-        components[food] = servings;
+        components.emplace(position, Component{std::move(food), servings});
     }
 }
 
-std::map<std::shared_ptr<Food>, double> CompositeFood::getComponents() const {
-    return components;
+void CompositeFood::setComponents(ComponentView newComponents) {
+    if (newComponents.begin() == components.begin()) {
+        return;
+    }
+    components.clear();
+    components.reserve(newComponents.size());
+    for (const auto& component : newComponents) {
+        components.emplace_back(component);
+    }
+}
+
+CompositeFood::ComponentView CompositeFood::getComponents() const {
+    return ComponentView(components.data(), components.size());
 }
 
 double CompositeFood::getCaloriesPerServing() const {
+    Metrics::Timer timer(Metrics::Id::COMPOSITE_CALORIES);
     double totalCalories = 0.0;
     
     // Sum up calories from all components
     for (const auto& component : components) {
-        totalCalories += component.first->getCaloriesPerServing() * component.second;
+        totalCalories += caloriesOf(*component.food) * component.servings;
     }
     
     return totalCalories;
@@ -49,7 +70,7 @@ std::string CompositeFood::toString() const {
         if (!first) {
             ss << ";";
         }
-        ss << component.first->getId() << "=" << component.second;
+        ss << component.food->getIdView() << "=" << component.servings;
         first = false;
     }
     
@@ -57,49 +78,34 @@ std::string CompositeFood::toString() const {
 }
 
 std::shared_ptr<CompositeFood> CompositeFood::fromString(const std::string& str, 
-                                                        const std::map<std::string, std::shared_ptr<Food>>& foodMap) {
-    std::stringstream ss(str);
-    std::string type, id, keywordStr, componentsStr;
+                                                        const std::map<std::string, std::shared_ptr<Food>, std::less<>>& foodMap,
+                                                        const std::shared_ptr<FoodArena>& arena) {
+    std::string_view rest(str);
     
     // Parse the string: "COMPOSITE:id:keyword1,keyword2,...:foodId=servings;foodId=servings;..."
-    std::getline(ss, type, ':');
-    if (type != "COMPOSITE") {
+    if (nextField(rest, ':') != "COMPOSITE") {
         throw std::invalid_argument("Not a composite food entry");
     }
     
-    std::getline(ss, id, ':');
-    std::getline(ss, keywordStr, ':');
-    std::getline(ss, componentsStr);
-    
-    // Parse keywords
-    std::vector<std::string> keywords;
-    std::stringstream keywordStream(keywordStr);
-    std::string keyword;
-    while (std::getline(keywordStream, keyword, ',')) {
-        keywords.push_back(keyword);
-    }
+    std::string id(nextField(rest, ':'));
+    std::vector<std::string> keywords = parseKeywords(nextField(rest, ':'));
     
     // Create the composite food
-    auto compositeFood = std::make_shared<CompositeFood>(id, keywords);
+    auto compositeFood = FoodArena::make<CompositeFood>(arena, id, keywords);
     
     // Parse components
-    std::stringstream componentStream(componentsStr);
-    std::string componentStr;
-    while (std::getline(componentStream, componentStr, ';')) {
-        std::stringstream componentParts(componentStr);
-        std::string foodId, servingsStr;
-        
-        std::getline(componentParts, foodId, '=');
-        std::getline(componentParts, servingsStr);
+    while (!rest.empty()) {
+        std::string_view componentParts = nextField(rest, ';');
+        std::string_view foodId = nextField(componentParts, '=');
         
-        double servings = std::stod(servingsStr);
+        double servings = std::stod(std::string(componentParts));
         
         // Find the food in the food map
         auto foodIter = foodMap.find(foodId);
         if (foodIter != foodMap.end()) {
             compositeFood->addComponent(foodIter->second, servings);
         } else {
-            throw std::runtime_error("Component food not found: " + foodId);
+            throw std::runtime_error("Component food not found: " + std::string(foodId));
         }
     }
     
@@ -119,7 +125,7 @@ void CompositeFood::display() const {
     std::cout << "  Components:" << std::endl;
     
     for (const auto& component : components) {
-        std::cout << "    " << component.first->getId() << ": " << component.second << " serving(s)" << std::endl;
+        std::cout << "    " << component.food->getIdView() << ": " << component.servings << " serving(s)" << std::endl;
     }
     
     std::cout << "  Total calories per serving: " << getCaloriesPerServing() << std::endl;
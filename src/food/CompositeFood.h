@@ -2,6 +2,9 @@
 #define COMPOSITE_FOOD_H
 
 #include "Food.h"
+#include "FoodArena.h"
+#include "../utils/SmallVector.h"
+#include <cstddef>
 #include <map>
 
 /**
@@ -9,25 +12,58 @@
  */
 class CompositeFood : public Food {
 public:
+    /**
+     * @brief One ingredient of a composite food
+     */
+    struct Component {
+        std::shared_ptr<Food> food; // The ingredient
+        double servings;            // Servings of it per serving of the composite
+    };
+    
+    /**
+     * @brief Read-only view of the components, sorted by food ID; valid until they change
+     */
+    class ComponentView {
+    public:
+        ComponentView(const Component* first, size_t count) : first(first), count(count) {}
+        const Component* begin() const { return first; }
+        const Component* end() const { return first + count; }
+        const Component& operator[](size_t index) const { return first[index]; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        
+    private:
+        const Component* first;
+        size_t count;
+    };
+    
     /**
      * @brief Constructor for CompositeFood
      * @param id The unique identifier for the food
      * @param keywords List of search keywords for this food
+     * @param memory Resource for the ID, keywords and components
      */
-    CompositeFood(const std::string& id, const std::vector<std::string>& keywords);
+    CompositeFood(const std::string& id, const std::vector<std::string>& keywords,
+                  std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     
     /**
      * @brief Add a component food with specified servings
      * @param food Shared pointer to the component food
-     * @param servings Number of servings of the component food
+     * @param servings Number of servings of the component food; added to any it already has
      */
     void addComponent(std::shared_ptr<Food> food, double servings);
     
     /**
-     * @brief Get the component foods and their servings
-     * @return Map of food pointers to servings
+     * @brief Get the component foods and their servings without copying them
+     * @return View of the components in food ID order
      */
-    std::map<std::shared_ptr<Food>, double> getComponents() const;
+    ComponentView getComponents() const;
+    
+    /**
+     * @brief Replace all components of this composite food
+     * @param newComponents The new components, in food ID order
+     */
+    void setComponents(ComponentView newComponents);
     
     /**
      * @brief Get calories per serving
@@ -45,10 +81,12 @@ public:
      * @brief Create a CompositeFood object from a string representation and a food database
      * @param str String representation of the CompositeFood
      * @param foodMap Map of food IDs to Food objects
+     * @param arena Arena to create the food in, or nullptr for the heap
      * @return Shared pointer to a new CompositeFood object
      */
     static std::shared_ptr<CompositeFood> fromString(const std::string& str, 
-                                                    const std::map<std::string, std::shared_ptr<Food>>& foodMap);
+                                                    const std::map<std::string, std::shared_ptr<Food>, std::less<>>& foodMap,
+                                                    const std::shared_ptr<FoodArena>& arena = nullptr);
     
     /**
      * @brief Display food information
@@ -56,7 +94,10 @@ public:
     void display() const override;
 
 private:
-    std::map<std::shared_ptr<Food>, double> components; // Map of component foods to servings
+    // Typical recipes fit inline, so most composites need no allocation for their components
+    static const size_t INLINE_COMPONENTS = 4;
+    
+    SmallVector<Component, INLINE_COMPONENTS> components; // Sorted by food ID
 };
 
 #endif // COMPOSITE_FOOD_H
\ No newline at end of file
@@ -1,69 +1,111 @@
 #include "Food.h"
+#include "../utils/StringSearch.h"
 #include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <string_view>
 
-Food::Food(const std::string& id, const std::vector<std::string>& keywords)
-    : id(id), keywords(keywords) {}
+Food::Food(FoodKind kind, const std::string& id, const std::vector<std::string>& keywords,
+           std::pmr::memory_resource* memory)
+    : kind(kind), id(id, memory), keywords(memory), foldedKeywords(memory) {
+    setKeywords(keywords);
+}
 
 std::string Food::getId() const {
-    return id;
+    return std::string(id);
 }
 
 std::vector<std::string> Food::getKeywords() const {
-    return keywords;
+    return std::vector<std::string>(keywords.begin(), keywords.end());
 }
 
 void Food::addKeyword(const std::string& keyword) {
     // Check if keyword already exists
-    if (std::find(keywords.begin(), keywords.end(), keyword) == keywords.end()) {
-        keywords.push_back(keyword);
+    if (std::find(keywords.begin(), keywords.end(), std::string_view(keyword)) == keywords.end()) {
+        keywords.emplace_back(keyword);
+        foldKeywords();
+    }
+}
+
+void Food::setKeywords(const std::vector<std::string>& newKeywords) {
+    // Assigning element by element keeps the keywords in this food's memory resource
+    keywords.clear();
+    keywords.reserve(newKeywords.size());
+    for (const auto& keyword : newKeywords) {
+        keywords.emplace_back(keyword);
+    }
+    foldKeywords();
+}
+
+void Food::foldKeywords() {
+    foldedKeywords.clear();
+    for (const auto& keyword : keywords) {
+        for (char c : keyword) {
+            foldedKeywords += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        foldedKeywords += '\0';
     }
 }
 
+std::string_view Food::nextField(std::string_view& rest, char delimiter) {
+    size_t end = rest.find(delimiter);
+    std::string_view field = rest.substr(0, end);
+    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+    return field;
+}
+
+std::vector<std::string> Food::parseKeywords(std::string_view field) {
+    std::vector<std::string> result;
+    while (!field.empty()) {
+        result.emplace_back(nextField(field, ','));
+    }
+    return result;
+}
+
 bool Food::matchesAllKeywords(const std::vector<std::string>& searchKeywords) const {
+    std::vector<std::string> folded;
+    folded.reserve(searchKeywords.size());
     for (const auto& keyword : searchKeywords) {
-        // Convert keyword to lowercase for case-insensitive matching
-        std::string lowerKeyword = keyword;
-        std::transform(lowerKeyword.begin(), lowerKeyword.end(), lowerKeyword.begin(), ::tolower);
-        
-        bool found = false;
-        for (const auto& foodKeyword : keywords) {
-            // Convert food keyword to lowercase for comparison
-            std::string lowerFoodKeyword = foodKeyword;
-            std::transform(lowerFoodKeyword.begin(), lowerFoodKeyword.end(), lowerFoodKeyword.begin(), ::tolower);
-            
-            if (lowerFoodKeyword.find(lowerKeyword) != std::string::npos) {
-                found = true;
-                break;
-            }
-        }
-        
-        if (!found) {
+        folded.push_back(StringSearch::foldCase(keyword));
+    }
+    return matchesAllFoldedKeywords(folded);
+}
+
+bool Food::matchesAnyKeyword(const std::vector<std::string>& searchKeywords) const {
+    std::vector<std::string> folded;
+    folded.reserve(searchKeywords.size());
+    for (const auto& keyword : searchKeywords) {
+        folded.push_back(StringSearch::foldCase(keyword));
+    }
+    return matchesAnyFoldedKeyword(folded);
+}
+
+bool Food::matchesAllFoldedKeywords(const std::vector<std::string>& foldedSearchKeywords) const {
+    for (const auto& keyword : foldedSearchKeywords) {
+        if (!containsFolded(keyword)) {
             return false; // If any keyword doesn't match, return false
         }
     }
     return true; // All keywords matched
 }
 
-bool Food::matchesAnyKeyword(const std::vector<std::string>& searchKeywords) const {
-    if (searchKeywords.empty()) {
+bool Food::matchesAnyFoldedKeyword(const std::vector<std::string>& foldedSearchKeywords) const {
+    if (foldedSearchKeywords.empty()) {
         return true; // If no search keywords provided, match everything
     }
     
-    for (const auto& keyword : searchKeywords) {
-        // Convert keyword to lowercase for case-insensitive matching
-        std::string lowerKeyword = keyword;
-        std::transform(lowerKeyword.begin(), lowerKeyword.end(), lowerKeyword.begin(), ::tolower);
-        
-        for (const auto& foodKeyword : keywords) {
-            // Convert food keyword to lowercase for comparison
-            std::string lowerFoodKeyword = foodKeyword;
-            std::transform(lowerFoodKeyword.begin(), lowerFoodKeyword.end(), lowerFoodKeyword.begin(), ::tolower);
-            
-            if (lowerFoodKeyword.find(lowerKeyword) != std::string::npos) {
-                return true; // Found a match
-            }
+    for (const auto& keyword : foldedSearchKeywords) {
+        if (containsFolded(keyword)) {
+            return true; // Found a match
         }
     }
     return false; // No matches found
-}
\ No newline at end of file
+}
+
+bool Food::containsFolded(std::string_view term) const {
+    // An empty term is a substring of every keyword, so it needs at least one
+    if (term.empty()) {
+        return !keywords.empty();
+    }
+    return StringSearch::contains(foldedKeywords, term);
+}
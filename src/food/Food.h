@@ -4,6 +4,19 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
+
+/**
+ * @brief The concrete kinds of food
+ *
+ * The set is closed, so hot loops can branch on the kind and call the concrete class
+ * directly (see FoodDispatch.h) instead of going through the virtual interface.
+ */
+enum class FoodKind {
+    BASIC,
+    COMPOSITE
+};
 
 /**
  * @brief Abstract base class for all food items in the system
@@ -12,22 +25,37 @@ class Food {
 public:
     /**
      * @brief Constructor for Food
+     * @param kind The concrete kind of the food
      * @param id The unique identifier for the food
      * @param keywords List of search keywords for this food
+     * @param memory Resource for the ID and keywords (an arena when loading a catalog)
      */
-    Food(const std::string& id, const std::vector<std::string>& keywords);
+    Food(FoodKind kind, const std::string& id, const std::vector<std::string>& keywords,
+         std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     
     /**
      * @brief Virtual destructor
      */
     virtual ~Food() = default;
     
+    /**
+     * @brief Get the concrete kind of the food
+     * @return BASIC or COMPOSITE
+     */
+    FoodKind getKind() const { return kind; }
+    
     /**
      * @brief Get the identifier of the food
      * @return The food identifier
      */
     std::string getId() const;
     
+    /**
+     * @brief Get the identifier of the food without copying it
+     * @return View of the identifier, valid while the food exists
+     */
+    std::string_view getIdView() const { return id; }
+    
     /**
      * @brief Get the search keywords for this food
      * @return Vector of keywords
@@ -40,6 +68,12 @@ public:
      */
     void addKeyword(const std::string& keyword);
     
+    /**
+     * @brief Replace all search keywords of this food
+     * @param keywords The new keywords
+     */
+    void setKeywords(const std::vector<std::string>& keywords);
+    
     /**
      * @brief Check if the food matches all the given keywords
      * @param keywords List of keywords to match
@@ -54,6 +88,38 @@ public:
      */
     bool matchesAnyKeyword(const std::vector<std::string>& keywords) const;
     
+    /**
+     * @brief Check if the food matches all the given lowercase keywords; skips folding the query
+     * @param foldedKeywords Lowercase keywords to match
+     * @return true if all keywords match, false otherwise
+     */
+    bool matchesAllFoldedKeywords(const std::vector<std::string>& foldedKeywords) const;
+    
+    /**
+     * @brief Check if the food matches any of the given lowercase keywords; skips folding the query
+     * @param foldedKeywords Lowercase keywords to match
+     * @return true if any keyword matches, false otherwise
+     */
+    bool matchesAnyFoldedKeyword(const std::vector<std::string>& foldedKeywords) const;
+    
+    /**
+     * @brief Get the keywords in lowercase, each followed by '\0'
+     * @return View of the folded keywords, valid until the keywords change
+     */
+    std::string_view getFoldedKeywords() const { return foldedKeywords; }
+    
+    /**
+     * @brief Call a visitor with each keyword in lowercase, without copying
+     * @param visitor Callable taking std::string_view
+     */
+    template <typename Visitor>
+    void forEachFoldedKeyword(Visitor&& visitor) const {
+        std::string_view all(foldedKeywords);
+        while (!all.empty()) {
+            visitor(nextField(all, '\0'));
+        }
+    }
+    
     /**
      * @brief Get calories per serving
      * @return Calories per serving
@@ -75,11 +141,44 @@ public:
      * @brief Get the name (ID) of the food
      * @return Food name
      */
-    std::string getName() const { return id; }
+    std::string getName() const { return std::string(id); }
 
 protected:
-    std::string id;                    // Unique identifier
-    std::vector<std::string> keywords; // Search keywords
+    /**
+     * @brief Take the next field of a line, like std::getline with a delimiter
+     * @param rest The unread part of the line; advanced past the field and its delimiter
+     * @param delimiter Character that ends the field
+     * @return The field, without the delimiter
+     */
+    static std::string_view nextField(std::string_view& rest, char delimiter);
+
+    /**
+     * @brief Split a comma-separated keyword list the way the food files store it
+     * @param field The keyword field of a line
+     * @return The keywords
+     */
+    static std::vector<std::string> parseKeywords(std::string_view field);
+
+    FoodKind kind;                               // Concrete type, for static dispatch
+    std::pmr::string id;                         // Unique identifier
+    std::pmr::vector<std::pmr::string> keywords; // Search keywords
+    
+private:
+    /**
+     * @brief Check if a lowercase term occurs in any keyword
+     * @param term The term
+     * @return true if some keyword contains it
+     */
+    bool containsFolded(std::string_view term) const;
+    
+    /**
+     * @brief Rebuild foldedKeywords after the keywords change
+     */
+    void foldKeywords();
+    
+    // Lowercase keywords, each followed by '\0'. A term without '\0' can only match
+    // inside one keyword, so a whole food is tested with a single substring search.
+    std::pmr::string foldedKeywords;
 };
 
 #endif // FOOD_H
\ No newline at end of file
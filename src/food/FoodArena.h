@@ -0,0 +1,91 @@
+#ifndef FOOD_ARENA_H
+#define FOOD_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+/**
+ * @brief Monotonic memory for foods built together, such as a whole catalog load
+ *
+ * Foods made with make() live in the arena together with their IDs, keywords and
+ * components, so loading a catalog takes a few large allocations instead of several per
+ * food. Nothing is returned to the heap until the last of those foods is gone: each one
+ * holds a reference to the arena. Like the rest of the food database, an arena must not be
+ * allocated from by two threads at once.
+ */
+class FoodArena {
+public:
+    /**
+     * @brief Create an arena
+     * @param initialBytes Size of the first block; later blocks grow geometrically
+     * @return The new arena
+     */
+    static std::shared_ptr<FoodArena> create(std::size_t initialBytes) {
+        return std::shared_ptr<FoodArena>(new FoodArena(initialBytes));
+    }
+
+    FoodArena(const FoodArena&) = delete;
+    FoodArena& operator=(const FoodArena&) = delete;
+
+    /**
+     * @brief Get the memory resource for the members of foods in this arena
+     * @return The arena's resource
+     */
+    std::pmr::memory_resource* resource() { return &buffer; }
+
+    /**
+     * @brief Allocator for the shared_ptr control block and object of a food; keeps the arena alive
+     */
+    template <typename T>
+    class Allocator {
+    public:
+        using value_type = T;
+
+        explicit Allocator(std::shared_ptr<FoodArena> arena) : arena(std::move(arena)) {}
+
+        template <typename U>
+        Allocator(const Allocator<U>& other) : arena(other.arena) {}
+
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(arena->buffer.allocate(n * sizeof(T), alignof(T)));
+        }
+
+        // Monotonic: memory comes back only when the arena is destroyed
+        void deallocate(T*, std::size_t) {}
+
+        template <typename U>
+        bool operator==(const Allocator<U>& other) const { return arena == other.arena; }
+
+        template <typename U>
+        bool operator!=(const Allocator<U>& other) const { return arena != other.arena; }
+
+    private:
+        template <typename U>
+        friend class Allocator;
+
+        std::shared_ptr<FoodArena> arena;
+    };
+
+    /**
+     * @brief Create a food in an arena, or on the heap if there is none
+     * @param arena The arena, or nullptr for the heap
+     * @param args Constructor arguments of the food, without the memory resource
+     * @return The new food
+     */
+    template <typename T, typename... Args>
+    static std::shared_ptr<T> make(const std::shared_ptr<FoodArena>& arena, Args&&... args) {
+        if (!arena) {
+            return std::make_shared<T>(std::forward<Args>(args)...);
+        }
+        return std::allocate_shared<T>(Allocator<T>(arena), std::forward<Args>(args)..., arena->resource());
+    }
+
+private:
+    explicit FoodArena(std::size_t initialBytes) : buffer(initialBytes > 0 ? initialBytes : 1) {}
+
+    std::pmr::monotonic_buffer_resource buffer; // Grows from the default (heap) resource
+};
+
+#endif // FOOD_ARENA_H
@@ -0,0 +1,19 @@
+#ifndef FOOD_DISPATCH_H
+#define FOOD_DISPATCH_H
+
+#include "BasicFood.h"
+#include "CompositeFood.h"
+
+/**
+ * @brief Get calories per serving without a virtual call; same result as getCaloriesPerServing()
+ * @param food The food
+ * @return Calories per serving
+ */
+inline double caloriesOf(const Food& food) {
+    if (food.getKind() == FoodKind::BASIC) {
+        return static_cast<const BasicFood&>(food).BasicFood::getCaloriesPerServing();
+    }
+    return static_cast<const CompositeFood&>(food).CompositeFood::getCaloriesPerServing();
+}
+
+#endif // FOOD_DISPATCH_H
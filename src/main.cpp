@@ -2,33 +2,184 @@
 #include "food/BasicFood.h"
 #include "food/CompositeFood.h"
 #include "database/FoodDatabase.h"
+#include "database/FoodImporter.h"
 #include "diet_goal/DietGoalProfile.h"
 #include "daily_log/DailyLog.h"
+#include "tenant/TenantRegistry.h"
+#include "analytics/LogAnalytics.h"
+#include "utils/DateUtils.h"
 #include "utils/FileHandler.h"
+#include "utils/PersistenceWorker.h"
+#include "utils/Metrics.h"
+#include "utils/MemoryAccounting.h"
+#include "utils/Tracer.h"
+#include "database/FoodFileWatcher.h"
+#include "batch/CommandProcessor.h"
+#include "server/CommandServer.h"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <sstream>
+#include <fstream>
 #include <memory>
 #include <algorithm>
 #include <limits>
+#include <mutex>
+#include <cstdlib>
+#include <csignal>
 
 // Function prototypes
 void displayMainMenu();
-void manageFoodDatabase(FoodDatabase &db);
-void manageDailyLogs(FoodDatabase &db, LogManager &logManager);
-void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager);
+void manageFoodDatabase(FoodDatabase &db, PersistenceWorker &persistence, FoodFileWatcher *watcher);
+void manageDailyLogs(FoodDatabase &db, LogManager &logManager, PersistenceWorker &persistence, FoodFileWatcher *watcher);
+void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager, PersistenceWorker &persistence);
+
+// Background saving: tell the persistence worker which data changed; it renders and writes it
+void queueFoodsSave(PersistenceWorker &persistence, FoodDatabase &db, FoodFileWatcher *watcher);
+void queueLogsSave(PersistenceWorker &persistence, LogManager &logManager);
+void queueProfileSave(PersistenceWorker &persistence, DietGoalProfile &profile);
+int runAnalytics(FoodDatabase &db, const std::string &fromDate, const std::string &toDate, size_t threads);
+
+// Batch mode: run commands from a file (or stdin if path is empty) without prompts
+int runBatch(FoodDatabase &db, LogManager &logManager, DietGoalProfile &profile, const std::string &path);
+
+// Daemon mode: serve the same commands to local clients over a Unix domain socket
+int runServer(FoodDatabase &db, LogManager &logManager, DietGoalProfile &profile, const std::string &socketPath,
+              size_t threads, FoodFileWatcher *watcher);
+
+// Load the saved profile if there is one, without prompting for a new one
+void loadExistingProfile(DietGoalProfile &profile);
+
+// Performance statistics: timings of the instrumented operations and memory per subsystem (--stats or main menu)
+void displayPerformanceStatistics();
+
+// Prints the statistics when main returns, after the database's final save
+struct StatisticsDump
+{
+    bool enabled = false;
+    ~StatisticsDump()
+    {
+        if (enabled)
+        {
+            std::cerr << "\n=== Performance Statistics ===" << std::endl;
+            Metrics::report(std::cerr);
+            if (MemoryAccounting::isAvailable())
+            {
+                // Everything has been freed by now, so the peaks are what matter here
+                std::cerr << "\n=== Memory Usage ===" << std::endl;
+                MemoryAccounting::report(std::cerr);
+            }
+        }
+    }
+};
+
+// Writes the trace file (--trace) when main returns, after the database's final save
+struct TraceDump
+{
+    ~TraceDump()
+    {
+        Tracer::finish();
+    }
+};
+
+// Hot reload: apply outside edits of the food files (--watch); true if any food changed
+bool pollFoodFiles(FoodFileWatcher *watcher);
 
 // Food Database Operations
 void displayMenu();
-void addBasicFood(FoodDatabase &db);
-void createCompositeFood(FoodDatabase &db);
+void addBasicFood(FoodDatabase &db, std::mutex &state);
+void createCompositeFood(FoodDatabase &db, std::mutex &state);
 void searchFoods(FoodDatabase &db);
+void queryFoods(FoodDatabase &db);
+void findFoodsByCalories(FoodDatabase &db);
+void updateFoodCalories(FoodDatabase &db, std::mutex &state);
 void displayAllFoods(FoodDatabase &db);
+void importFoods(FoodDatabase &db, std::mutex &state);
+void displaySearchCacheStats(FoodDatabase &db);
 std::vector<std::string> splitString(const std::string &str, char delimiter);
 
-int main()
+int main(int argc, char *argv[])
 {
+    std::string userId;
+    bool analytics = false;
+    std::string fromDate, toDate;
+    size_t threads = 0;
+    bool watch = false;
+    bool batch = false;
+    std::string batchPath;
+    bool serve = false;
+    std::string socketPath = "data/yada.sock";
+    StatisticsDump statistics; // Declared before the database so it reports the final save too
+    TraceDump trace;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--user" && i + 1 < argc)
+        {
+            userId = argv[++i];
+        }
+        else if (arg == "--analytics")
+        {
+            analytics = true;
+        }
+        else if (arg == "--from" && i + 1 < argc)
+        {
+            fromDate = argv[++i];
+        }
+        else if (arg == "--to" && i + 1 < argc)
+        {
+            toDate = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threads = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--stats")
+        {
+            statistics.enabled = true;
+            Metrics::setEnabled(true);
+        }
+        else if (arg == "--trace" && i + 1 < argc)
+        {
+            Tracer::start(argv[++i]);
+        }
+        else if (arg == "--watch")
+        {
+            watch = true;
+        }
+        else if (arg == "--serve")
+        {
+            serve = true;
+            if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0)
+            {
+                socketPath = argv[++i];
+            }
+        }
+        else if (arg == "--batch")
+        {
+            batch = true;
+            if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0)
+            {
+                batchPath = argv[++i];
+            }
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--user <id>] [--watch] [--stats] [--trace <file.json>]" << std::endl;
+            std::cerr << "       " << argv[0] << " [--user <id>] --batch [file]" << std::endl;
+            std::cerr << "       " << argv[0] << " [--user <id>] --serve [socket] [--threads N]" << std::endl;
+            std::cerr << "       " << argv[0] << " --analytics [--from DD-MM-YYYY] [--to DD-MM-YYYY] [--threads N]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (watch && batch)
+    {
+        // A batch runs to completion and saves at the end, so there is nothing to keep up to date
+        std::cerr << "--watch cannot be combined with --batch" << std::endl;
+        return 1;
+    }
+
     // Create data directory if not exists
     FileHandler::createDirectoryIfNotExists("data");
 
@@ -41,15 +192,74 @@ int main()
         std::cout << "Failed to load food database. Starting with an empty database." << std::endl;
     }
 
-    // Initialize log manager
-    LogManager logManager("data/daily_logs.txt");
-    if (!logManager.loadLogs(foodDB))
+    if (analytics)
+    {
+        return runAnalytics(foodDB, fromDate, toDate, threads);
+    }
+
+    // Users share the food database; each user's logs and profile live under data/users
+    TenantRegistry tenants(foodDB, "data/users");
+    TenantHandle tenant;
+    std::unique_ptr<LogManager> sharedLogManager;
+    std::unique_ptr<DietGoalProfile> sharedProfile;
+    if (!userId.empty())
+    {
+        try
+        {
+            tenant = tenants.acquire(userId);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        if (!batch && !serve)
+        {
+            std::cout << "Logged in as " << userId << "." << std::endl;
+        }
+    }
+    else
+    {
+        // Initialize log manager
+        sharedLogManager = std::make_unique<LogManager>("data/daily_logs.txt");
+        if (!sharedLogManager->loadLogs(foodDB))
+        {
+            std::cout << "Failed to load daily logs. Starting with an empty log." << std::endl;
+        }
+
+        // Initialize diet goal profile
+        sharedProfile = std::make_unique<DietGoalProfile>("data/diet_profile.txt");
+    }
+    LogManager &logManager = tenant ? tenant->getLogManager() : *sharedLogManager;
+    DietGoalProfile &dietProfile = tenant ? tenant->getProfile() : *sharedProfile;
+
+    if (batch)
+    {
+        return runBatch(foodDB, logManager, dietProfile, batchPath);
+    }
+
+    // Pick up edits other programs make to the food files while we run
+    std::unique_ptr<FoodFileWatcher> watcher;
+    if (watch)
+    {
+        try
+        {
+            watcher = std::make_unique<FoodFileWatcher>(foodDB);
+            std::cout << "Watching the food database files for changes." << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    if (serve)
     {
-        std::cout << "Failed to load daily logs. Starting with an empty log." << std::endl;
+        return runServer(foodDB, logManager, dietProfile, socketPath, threads, watcher.get());
     }
 
-    // Initialize diet goal profile
-    DietGoalProfile dietProfile("data/diet_profile.txt");
+    // Changes are saved in the background; every snapshot is written before main returns
+    PersistenceWorker persistence;
 
     bool running = true;
     while (running)
@@ -61,20 +271,37 @@ int main()
         std::cin >> choice;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
 
+        // Catch up before acting, so saving on exit can't overwrite an outside edit
+        {
+            std::lock_guard<std::mutex> stateLock(persistence.stateMutex());
+            if (pollFoodFiles(watcher.get()))
+            {
+                logManager.rebuildCalorieTotals();
+            }
+        }
+
         switch (choice)
         {
         case 1:
-            manageFoodDatabase(foodDB);
+        {
+            manageFoodDatabase(foodDB, persistence, watcher.get());
+            // Foods may have been re-priced, so refresh the per-day totals
+            std::lock_guard<std::mutex> stateLock(persistence.stateMutex());
+            logManager.rebuildCalorieTotals();
             break;
+        }
         case 2:
-            manageDailyLogs(foodDB, logManager);
+            manageDailyLogs(foodDB, logManager, persistence, watcher.get());
             break;
         case 3:
-            manageDietGoalProfile(dietProfile, logManager);
+            manageDietGoalProfile(dietProfile, logManager, persistence);
             break;
         case 4:
-            // Save database, logs, and exit
-            if (foodDB.saveFoods() && logManager.saveLogs() && dietProfile.saveToFile())
+            // Save database, logs, and exit; all files are written as one group commit
+            queueFoodsSave(persistence, foodDB, watcher.get());
+            queueLogsSave(persistence, logManager);
+            queueProfileSave(persistence, dietProfile);
+            if (persistence.flush())
             {
                 std::cout << "Database and logs saved successfully." << std::endl;
                 running = false;
@@ -84,7 +311,15 @@ int main()
                 std::cout << "Failed to save database or logs." << std::endl;
             }
             break;
+        case 5:
+            displayPerformanceStatistics();
+            break;
         case 0:
+            // Every change was already handed to the background writer; wait for it
+            if (!persistence.flush())
+            {
+                std::cout << "Warning: Some changes could not be saved." << std::endl;
+            }
             running = false;
             break;
         default:
@@ -106,7 +341,8 @@ void displayMainMenu()
     std::cout << "2. Manage Daily Logs" << std::endl;
     std::cout << "3. Manage Diet Goal Profile" << std::endl;
     std::cout << "4. Save and Exit" << std::endl;
-    std::cout << "0. Exit Without Saving" << std::endl;
+    std::cout << "5. Performance Statistics" << std::endl;
+    std::cout << "0. Exit (changes are saved automatically)" << std::endl;
     std::cout << "=======================================" << std::endl;
 }
 
@@ -122,11 +358,16 @@ void displayMenu()
     std::cout << "3. Search Foods" << std::endl;
     std::cout << "4. Display All Foods" << std::endl;
     std::cout << "5. Save Database" << std::endl;
+    std::cout << "6. Import Foods from File" << std::endl;
+    std::cout << "7. Show Search Cache Statistics" << std::endl;
+    std::cout << "8. Search with Boolean Query" << std::endl;
+    std::cout << "9. Find Foods by Calories" << std::endl;
+    std::cout << "10. Update Basic Food Calories" << std::endl;
     std::cout << "0. Return to Main Menu" << std::endl;
     std::cout << "=======================================" << std::endl;
 }
 
-void addBasicFood(FoodDatabase &db)
+void addBasicFood(FoodDatabase &db, std::mutex &state)
 {
     std::string id, keywordsStr;
     double calories;
@@ -158,6 +399,7 @@ void addBasicFood(FoodDatabase &db)
 
     // Create and add the basic food
     auto basicFood = std::make_shared<BasicFood>(id, keywords, calories);
+    std::lock_guard<std::mutex> stateLock(state);
     if (db.addBasicFood(basicFood))
     {
         std::cout << "Basic food added successfully." << std::endl;
@@ -168,7 +410,7 @@ void addBasicFood(FoodDatabase &db)
     }
 }
 
-void createCompositeFood(FoodDatabase &db)
+void createCompositeFood(FoodDatabase &db, std::mutex &state)
 {
     std::string id, keywordsStr;
 
@@ -236,6 +478,7 @@ void createCompositeFood(FoodDatabase &db)
     }
 
     // Add the composite food to the database
+    std::lock_guard<std::mutex> stateLock(state);
     if (db.addCompositeFood(compositeFood))
     {
         std::cout << "Composite food created successfully." << std::endl;
@@ -286,11 +529,153 @@ void searchFoods(FoodDatabase &db)
     }
 }
 
+void queryFoods(FoodDatabase &db)
+{
+    std::string query;
+
+    std::cout << "=== Boolean Query Search ===" << std::endl;
+    std::cout << "Combine exact keywords with AND, OR, NOT, parentheses and calories<, <=, >, >=, = comparisons." << std::endl;
+    std::cout << "Example: protein AND NOT dairy AND calories<200" << std::endl;
+
+    // Get query
+    std::cout << "Enter query: ";
+    std::getline(std::cin, query);
+
+    try
+    {
+        auto results = db.findFoodsMatchingQuery(query);
+
+        // Display results
+        std::cout << "Search results (" << results.size() << " foods found):" << std::endl;
+        for (const auto &food : results)
+        {
+            food->display();
+            std::cout << std::endl;
+        }
+    }
+    catch (const std::invalid_argument &e)
+    {
+        std::cout << "Invalid query: " << e.what() << std::endl;
+    }
+}
+
+void findFoodsByCalories(FoodDatabase &db)
+{
+    char mode;
+
+    std::cout << "=== Find Foods by Calories ===" << std::endl;
+    std::cout << "Find foods in a (r)ange or (n)earest to a target? ";
+    std::cin >> mode;
+
+    std::vector<std::shared_ptr<Food>> results;
+    if (mode == 'n')
+    {
+        double target;
+        size_t count;
+        std::cout << "Enter target calories per serving: ";
+        std::cin >> target;
+        std::cout << "Enter number of foods to show: ";
+        std::cin >> count;
+        results = db.findFoodsNearestCalories(target, count);
+    }
+    else
+    {
+        double minCalories, maxCalories;
+        std::cout << "Enter minimum calories per serving: ";
+        std::cin >> minCalories;
+        std::cout << "Enter maximum calories per serving: ";
+        std::cin >> maxCalories;
+        results = db.findFoodsInCalorieRange(minCalories, maxCalories);
+    }
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
+
+    // Display results
+    std::cout << "Search results (" << results.size() << " foods found):" << std::endl;
+    for (const auto &food : results)
+    {
+        std::cout << "  " << food->getId() << ": " << food->getCaloriesPerServing() << " calories" << std::endl;
+    }
+}
+
+void updateFoodCalories(FoodDatabase &db, std::mutex &state)
+{
+    std::string id;
+    double calories;
+
+    std::cout << "=== Update Basic Food Calories ===" << std::endl;
+
+    // Get food ID
+    std::cout << "Enter basic food ID: ";
+    std::getline(std::cin, id);
+
+    // Get calories
+    std::cout << "Enter new calories per serving: ";
+    std::cin >> calories;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
+
+    std::lock_guard<std::mutex> stateLock(state);
+    if (db.updateBasicFoodCalories(id, calories))
+    {
+        std::cout << "Calories updated." << std::endl;
+    }
+    else
+    {
+        std::cout << "No basic food with this ID." << std::endl;
+    }
+}
+
 void displayAllFoods(FoodDatabase &db)
 {
     db.displayAllFoods();
 }
 
+void importFoods(FoodDatabase &db, std::mutex &state)
+{
+    std::string filePath;
+
+    std::cout << "=== Import Foods ===" << std::endl;
+    std::cout << "Rows must have the columns id, keywords, calories (CSV or TSV)." << std::endl;
+
+    // Get file path
+    std::cout << "Enter file path: ";
+    std::getline(std::cin, filePath);
+
+    try
+    {
+        FoodImporter importer(db);
+        ImportReport report;
+        {
+            std::lock_guard<std::mutex> stateLock(state);
+            report = importer.importFile(filePath);
+        }
+
+        std::cout << "Imported " << report.imported << " of " << report.rowsRead << " rows in "
+                  << report.seconds << " s (" << static_cast<long long>(report.rowsPerSecond()) << " rows/s)." << std::endl;
+        std::cout << "Rejected: " << report.rejectedMalformed << " malformed, "
+                  << report.rejectedDuplicate << " duplicate ID(s)." << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "Import failed: " << e.what() << std::endl;
+    }
+}
+
+void displaySearchCacheStats(FoodDatabase &db)
+{
+    SearchCacheStats stats = db.getSearchCacheStats();
+    size_t lookups = stats.hits + stats.misses;
+
+    std::cout << "=== Search Cache ===" << std::endl;
+    std::cout << "Cached queries: " << stats.entries << std::endl;
+    std::cout << "Hits: " << stats.hits << ", misses: " << stats.misses;
+    if (lookups > 0)
+    {
+        std::cout << " (" << (100.0 * stats.hits / lookups) << "% of searches skipped the scan)";
+    }
+    std::cout << std::endl;
+    std::cout << "Invalidations: " << stats.invalidations << ", evictions: " << stats.evictions << std::endl;
+}
+
 std::vector<std::string> splitString(const std::string &str, char delimiter)
 {
     std::vector<std::string> tokens;
@@ -312,7 +697,7 @@ std::vector<std::string> splitString(const std::string &str, char delimiter)
     return tokens;
 }
 
-void manageFoodDatabase(FoodDatabase &foodDB)
+void manageFoodDatabase(FoodDatabase &foodDB, PersistenceWorker &persistence, FoodFileWatcher *watcher)
 {
 
     bool running = true;
@@ -325,13 +710,20 @@ void manageFoodDatabase(FoodDatabase &foodDB)
         std::cin >> choice;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear input buffer
 
+        // Background saves read the database while the UI waits for input, so every change
+        // to it takes the state lock; reading it needs no lock on this thread
+        {
+            std::lock_guard<std::mutex> stateLock(persistence.stateMutex());
+            pollFoodFiles(watcher);
+        }
+
         switch (choice)
         {
         case 1:
-            addBasicFood(foodDB);
+            addBasicFood(foodDB, persistence.stateMutex());
             break;
         case 2:
-            createCompositeFood(foodDB);
+            createCompositeFood(foodDB, persistence.stateMutex());
             break;
         case 3:
             searchFoods(foodDB);
@@ -340,7 +732,8 @@ void manageFoodDatabase(FoodDatabase &foodDB)
             displayAllFoods(foodDB);
             break;
         case 5:
-            if (foodDB.saveFoods())
+            queueFoodsSave(persistence, foodDB, watcher);
+            if (persistence.flush())
             {
                 std::cout << "Database saved successfully." << std::endl;
             }
@@ -349,6 +742,21 @@ void manageFoodDatabase(FoodDatabase &foodDB)
                 std::cout << "Failed to save database." << std::endl;
             }
             break;
+        case 6:
+            importFoods(foodDB, persistence.stateMutex());
+            break;
+        case 7:
+            displaySearchCacheStats(foodDB);
+            break;
+        case 8:
+            queryFoods(foodDB);
+            break;
+        case 9:
+            findFoodsByCalories(foodDB);
+            break;
+        case 10:
+            updateFoodCalories(foodDB, persistence.stateMutex());
+            break;
         case 0:
             running = false;
             break;
@@ -356,21 +764,17 @@ void manageFoodDatabase(FoodDatabase &foodDB)
             std::cout << "Invalid choice. Please try again." << std::endl;
         }
 
-        std::cout << std::endl;
-    }
+        // Adding, importing and re-pricing foods change the database files
+        if (choice == 1 || choice == 2 || choice == 6 || choice == 10)
+        {
+            queueFoodsSave(persistence, foodDB, watcher);
+        }
 
-    // Save database on exit
-    if (foodDB.saveFoods())
-    {
-        std::cout << "Database saved successfully." << std::endl;
-    }
-    else
-    {
-        std::cout << "Failed to save database on exit." << std::endl;
+        std::cout << std::endl;
     }
 }
 
-void manageDailyLogs(FoodDatabase &db, LogManager &logManager)
+void manageDailyLogs(FoodDatabase &db, LogManager &logManager, PersistenceWorker &persistence, FoodFileWatcher *watcher)
 {
     bool managingLogs = true;
     while (managingLogs)
@@ -381,6 +785,9 @@ void manageDailyLogs(FoodDatabase &db, LogManager &logManager)
         std::cout << "3. Remove Food from Log" << std::endl;
         std::cout << "4. Undo Last Action" << std::endl;
         std::cout << "5. Save Logs" << std::endl; // Add this line
+        std::cout << "6. Calorie Statistics for Date Range" << std::endl;
+        std::cout << "7. Redo Last Undone Action" << std::endl;
+        std::cout << "8. Archive Old Days" << std::endl;
         std::cout << "0. Return to Main Menu" << std::endl;
 
         int choice;
@@ -388,6 +795,15 @@ void manageDailyLogs(FoodDatabase &db, LogManager &logManager)
         std::cin >> choice;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
+        // Background saves read the logs while the UI waits for input, so every change to
+        // them (including getLog, which may create the day) takes the state lock
+        std::unique_lock<std::mutex> stateLock(persistence.stateMutex());
+        if (pollFoodFiles(watcher))
+        {
+            logManager.rebuildCalorieTotals();
+        }
+        stateLock.unlock();
+
         std::string date;
         switch (choice)
         {
@@ -453,9 +869,9 @@ void manageDailyLogs(FoodDatabase &db, LogManager &logManager)
             auto food = db.getFoodById(foodId);
             if (food)
             {
-                DailyLog &log = logManager.getLog(date);
-                log.addFoodEntry(food, servings);
-                logManager.addUndoAction(LogManager::LogAction::ADD, date, food, servings);
+                stateLock.lock();
+                logManager.addFoodEntry(date, food, servings);
+                stateLock.unlock();
                 std::cout << "Food added to log." << std::endl;
             }
             else
@@ -473,12 +889,14 @@ void manageDailyLogs(FoodDatabase &db, LogManager &logManager)
                 std::cout << "Invalid date format. Please use DD-MM-YYYY." << std::endl;
                 break;
             }
+            stateLock.lock();
             auto &log = logManager.getLog(date);
+            stateLock.unlock();
             std::cout << "Log for " << date << ":" << std::endl;
-            for (size_t i = 0; i < log.getFoodEntries().size(); ++i)
+            size_t i = 0;
+            for (const auto &[id, entry] : log.getFoodEntries())
             {
-                const auto &entry = log.getFoodEntries()[i];
-                std::cout << i + 1 << ". " << entry.getFood()->getId()
+                std::cout << ++i << ". " << entry.getFood()->getId()
                           << " - " << entry.getServings() << " servings, "
                           << entry.getTotalCalories() << " calories" << std::endl;
             }
@@ -499,14 +917,10 @@ void manageDailyLogs(FoodDatabase &db, LogManager &logManager)
             std::cin >> index;
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-            auto &log = logManager.getLog(date);
-            size_t actualIndex = index - 1;
-            auto foodToRemove = log.getFoodEntries()[actualIndex].getFood();
-            double servingsToRemove = log.getFoodEntries()[actualIndex].getServings();
-
-            logManager.addUndoAction(LogManager::LogAction::REMOVE, date, foodToRemove, servingsToRemove, actualIndex);
-
-            if (log.removeFoodEntry(actualIndex))
+            stateLock.lock();
+            bool removed = index >= 1 && logManager.removeFoodEntry(date, index - 1);
+            stateLock.unlock();
+            if (removed)
             {
                 std::cout << "Food removed from log." << std::endl;
             }
@@ -517,11 +931,21 @@ void manageDailyLogs(FoodDatabase &db, LogManager &logManager)
             break;
         }
         case 4:
-            logManager.undo();
-            std::cout << "Last action undone." << std::endl;
+        {
+            std::string message;
+            stateLock.lock();
+            bool undone = logManager.undo(message);
+            stateLock.unlock();
+            std::cout << message << std::endl;
+            if (undone)
+            {
+                std::cout << "Last action undone." << std::endl;
+            }
             break;
+        }
         case 5:
-            if (logManager.saveLogs())
+            queueLogsSave(persistence, logManager);
+            if (persistence.flush())
             {
                 std::cout << "Logs saved successfully." << std::endl;
             }
@@ -530,21 +954,91 @@ void manageDailyLogs(FoodDatabase &db, LogManager &logManager)
                 std::cout << "Failed to save logs." << std::endl;
             }
             break;
+        case 6:
+        {
+            std::string fromDate, toDate;
+            std::cout << "Enter start date (DD-MM-YYYY): ";
+            std::getline(std::cin, fromDate);
+            std::cout << "Enter end date (DD-MM-YYYY): ";
+            std::getline(std::cin, toDate);
+
+            CalorieSummary summary;
+            if (!logManager.getCalorieSummary(fromDate, toDate, summary))
+            {
+                std::cout << "Invalid date format. Please use DD-MM-YYYY." << std::endl;
+                break;
+            }
+
+            std::cout << "\n=== Calories from " << fromDate << " to " << toDate << " ===" << std::endl;
+            std::cout << "Logged days: " << summary.days << std::endl;
+            if (summary.days > 0)
+            {
+                std::cout << "Total: " << summary.total << " calories" << std::endl;
+                std::cout << "Daily average: " << summary.average << " calories" << std::endl;
+                std::cout << "Lowest day: " << summary.minimum << " calories" << std::endl;
+                std::cout << "Highest day: " << summary.maximum << " calories" << std::endl;
+            }
+            break;
+        }
+        case 7:
+        {
+            std::string message;
+            stateLock.lock();
+            bool redone = logManager.redo(message);
+            stateLock.unlock();
+            std::cout << message << std::endl;
+            if (redone)
+            {
+                std::cout << "Last undone action redone." << std::endl;
+            }
+            break;
+        }
+        case 8:
+        {
+            std::cout << "Archive days before (DD-MM-YYYY): ";
+            std::getline(std::cin, date);
+
+            // The archive rewrites the log file, so queued snapshots of it must land first
+            persistence.flush();
+
+            size_t archivedDays = 0;
+            stateLock.lock();
+            bool archived = logManager.archiveDaysBefore(date, db, archivedDays);
+            stateLock.unlock();
+            if (archived)
+            {
+                std::cout << "Archived " << archivedDays << " days to " << logManager.getArchivePath() << "." << std::endl;
+            }
+            else
+            {
+                std::cout << "Failed to archive logs." << std::endl;
+            }
+            break;
+        }
         case 0:
             managingLogs = false;
             break;
         default:
             std::cout << "Invalid choice." << std::endl;
         }
+
+        // Adding, removing, undoing and redoing entries change the log file
+        if (choice == 1 || choice == 3 || choice == 4 || choice == 7)
+        {
+            queueLogsSave(persistence, logManager);
+        }
     }
 }
 
-void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
+void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager, PersistenceWorker &persistence)
 {
+    // Nothing queues a profile save before the profile is loaded, so the background saves
+    // can't be reading it yet and the prompts for a new one need no lock
     if (!profile.loaded())
     {
         try
         {
+            std::cout << "Loading diet profile..." << std::endl;
             profile.loadFromFile();
         }
         catch (const std::exception &e)
@@ -572,6 +1066,10 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
         std::cin >> choice;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
+        // Background saves read the profile while the UI waits for input, so every change to
+        // it takes the state lock, after the new value has been entered
+        std::unique_lock<std::mutex> stateLock(persistence.stateMutex(), std::defer_lock);
+
         switch (choice)
         {
         case 1:
@@ -581,6 +1079,7 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
             std::getline(std::cin, gender);
             try
             {
+                stateLock.lock();
                 profile.setGender(gender == "M" ? Gender::MALE : Gender::FEMALE);
             }
             catch (const std::exception &e)
@@ -597,6 +1096,7 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             try
             {
+                stateLock.lock();
                 profile.setHeight(height);
             }
             catch (const std::exception &e)
@@ -613,6 +1113,7 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             try
             {
+                stateLock.lock();
                 profile.setWeight(weight);
             }
             catch (const std::exception &e)
@@ -629,6 +1130,7 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             try
             {
+                stateLock.lock();
                 profile.setAge(age);
             }
             catch (const std::exception &e)
@@ -659,6 +1161,7 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
 
             if (levelChoice >= 1 && levelChoice <= 5)
             {
+                stateLock.lock();
                 profile.setActivityLevel(levels[levelChoice - 1]);
             }
             else
@@ -678,6 +1181,7 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
 
             if (methodChoice >= 1 && methodChoice <= 2)
             {
+                stateLock.lock();
                 profile.setCalorieCalculationMethod(methodChoice);
                 std::cout << "Setting method successful." << std::endl;
             }
@@ -712,13 +1216,27 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
 
                 // Ask user if they want to use current date or enter a different date
                 std::cout << "Current date is: " << currentDate << std::endl;
+                std::cout << "Enter date (DD-MM-YYYY) or press Enter for today: ";
+                std::string input;
+                std::getline(std::cin, input);
+                if (!input.empty())
+                {
+                    if (!logManager.isValidDateFormat(input))
+                    {
+                        std::cout << "Invalid date format. Please use DD-MM-YYYY." << std::endl;
+                        break;
+                    }
+                    currentDate = input;
+                }
 
-                // Get the daily log for this date
+                // Get the daily log for this date; getLog may create the day
+                stateLock.lock();
                 const DailyLog &log = logManager.getLog(currentDate);
+                stateLock.unlock();
 
-                // Calculate consumed and target calories
+                // Calculate consumed calories and the target of the profile in effect that day
                 double consumedCalories = log.getTotalCalories();
-                double targetCalories = profile.calculateTargetCalories();
+                double targetCalories = profile.calculateTargetCalories(currentDate);
                 double difference = consumedCalories - targetCalories;
 
                 // Display results
@@ -729,7 +1247,8 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
 
                 if (difference < 0)
                 {
-                    std::cout << "You have " << -difference << " calories available to consume today." << std::endl;
+                    std::cout << "You have " << -difference << " calories available to consume "
+                              << (input.empty() ? "today" : "on " + currentDate) << "." << std::endl;
                 }
                 else if (difference > 0)
                 {
@@ -752,5 +1271,211 @@ void manageDietGoalProfile(DietGoalProfile &profile, LogManager &logManager)
         default:
             std::cout << "Invalid choice." << std::endl;
         }
+
+        // Options 1-6 edit the profile
+        if (choice >= 1 && choice <= 6)
+        {
+            queueProfileSave(persistence, profile);
+        }
     }
-}
\ No newline at end of file
+}
+
+void queueFoodsSave(PersistenceWorker &persistence, FoodDatabase &db, FoodFileWatcher *watcher)
+{
+    // The files are rendered later on the worker; our own saves are not outside edits
+    persistence.submit(db.getBasicFoodFilePath(), [&db, watcher](std::string &contents)
+    {
+        contents = db.serializeBasicFoods();
+        if (watcher)
+        {
+            watcher->noteWrite(db.getBasicFoodFilePath(), contents);
+        }
+        return true;
+    });
+    persistence.submit(db.getCompositeFoodFilePath(), [&db, watcher](std::string &contents)
+    {
+        contents = db.serializeCompositeFoods();
+        if (watcher)
+        {
+            watcher->noteWrite(db.getCompositeFoodFilePath(), contents);
+        }
+        return true;
+    });
+}
+
+bool pollFoodFiles(FoodFileWatcher *watcher)
+{
+    if (!watcher)
+    {
+        return false;
+    }
+    size_t changed = watcher->poll();
+    if (changed == 0)
+    {
+        return false;
+    }
+    std::cout << "Reloaded " << changed << " changed foods from disk." << std::endl;
+    return true;
+}
+
+void queueLogsSave(PersistenceWorker &persistence, LogManager &logManager)
+{
+    persistence.submit(logManager.getLogFilePath(), [&logManager](std::string &contents)
+    {
+        contents = logManager.serializeLogs();
+        return true;
+    });
+}
+
+void queueProfileSave(PersistenceWorker &persistence, DietGoalProfile &profile)
+{
+    persistence.submit(profile.getFilePath(), [&profile](std::string &contents)
+    {
+        return profile.serialize(contents);
+    });
+}
+
+int runAnalytics(FoodDatabase &db, const std::string &fromDate, const std::string &toDate, size_t threads)
+{
+    int firstDay = std::numeric_limits<int>::min();
+    int lastDay = std::numeric_limits<int>::max();
+    if ((!fromDate.empty() && !DateUtils::toDayNumber(fromDate, firstDay)) ||
+        (!toDate.empty() && !DateUtils::toDayNumber(toDate, lastDay)))
+    {
+        std::cerr << "Invalid date format. Please use DD-MM-YYYY." << std::endl;
+        return 1;
+    }
+
+    std::vector<LogSource> sources = LogAnalytics::discover("data");
+    ThreadPool pool(threads);
+    LogAnalytics analytics(db, pool);
+    FleetCalorieReport report = analytics.run(sources, firstDay, lastDay);
+
+    std::cout << "=== Calorie Analytics ("
+              << (fromDate.empty() ? "start" : fromDate) << " to " << (toDate.empty() ? "end" : toDate)
+              << ") ===" << std::endl;
+    for (const auto &user : report.users)
+    {
+        const CalorieSummary &summary = user.summary;
+        std::cout << user.userId << ": " << summary.days << " days";
+        if (summary.days > 0)
+        {
+            std::cout << ", total " << summary.total << ", average " << summary.average
+                      << ", lowest " << summary.minimum << ", highest " << summary.maximum;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "\nUsers: " << report.users.size() << " (" << report.filesFailed << " unreadable)" << std::endl;
+    std::cout << "Logged user-days: " << report.allDays.days << std::endl;
+    if (report.allDays.days > 0)
+    {
+        std::cout << "Total: " << report.allDays.total << " calories" << std::endl;
+        std::cout << "Average per logged day: " << report.allDays.average << " calories" << std::endl;
+        std::cout << "Average of per-user daily averages: " << report.averageOfUserAverages << " calories" << std::endl;
+        std::cout << "Lowest day: " << report.allDays.minimum << ", highest day: " << report.allDays.maximum << std::endl;
+    }
+    std::cout << "Scanned " << report.filesScanned << " files on " << pool.size() << " threads in "
+              << report.seconds << " s" << std::endl;
+    return report.filesFailed == 0 ? 0 : 1;
+}
+
+int runBatch(FoodDatabase &db, LogManager &logManager, DietGoalProfile &profile, const std::string &path)
+{
+    std::ifstream file;
+    if (!path.empty())
+    {
+        file.open(path);
+        if (!file)
+        {
+            std::cerr << "Could not open batch file: " << path << std::endl;
+            return 1;
+        }
+    }
+    std::istream &input = path.empty() ? std::cin : file;
+
+    loadExistingProfile(profile);
+
+    // Nothing is interactive, so stdout can be written in large blocks
+    std::ios::sync_with_stdio(false);
+    const size_t flushThreshold = 64 * 1024;
+
+    CommandProcessor processor(db, logManager, profile);
+    std::string output;
+    std::string line;
+    size_t failures = 0;
+    while (std::getline(input, line))
+    {
+        if (!processor.execute(line, output))
+        {
+            ++failures;
+        }
+        if (output.size() >= flushThreshold)
+        {
+            std::cout.write(output.data(), output.size());
+            output.clear();
+        }
+    }
+    std::cout.write(output.data(), output.size());
+    std::cout.flush();
+
+    if (processor.hasUnsavedChanges() && !processor.save())
+    {
+        std::cerr << "Failed to save changes." << std::endl;
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int runServer(FoodDatabase &db, LogManager &logManager, DietGoalProfile &profile, const std::string &socketPath,
+              size_t threads, FoodFileWatcher *watcher)
+{
+    loadExistingProfile(profile);
+
+    // Threads inherit the signal mask, so block the shutdown signals before the pool starts;
+    // the server then reads them from a signalfd
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    ThreadPool pool(threads);
+    CommandServer server(db, logManager, profile, pool, watcher);
+    if (!server.run(socketPath))
+    {
+        return 1;
+    }
+    std::cout << "Server stopped after " << server.requestsServed() << " requests." << std::endl;
+    return 0;
+}
+
+void loadExistingProfile(DietGoalProfile &profile)
+{
+    // Without a prompt there is nobody to ask for a missing profile
+    if (!profile.loaded() && FileHandler::fileExists(profile.getFilePath()))
+    {
+        try
+        {
+            profile.loadFromFile();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Warning: Could not load diet profile: " << e.what() << std::endl;
+        }
+    }
+}
+
+void displayPerformanceStatistics()
+{
+    if (!Metrics::isEnabled())
+    {
+        // Off by default so the timers cost nothing; from here on they record
+        Metrics::setEnabled(true);
+        std::cout << "Statistics collection was off and is now on; use the program and check back." << std::endl;
+    }
+    std::cout << "\n=== Performance Statistics ===" << std::endl;
+    Metrics::report(std::cout);
+    std::cout << "\n=== Memory Usage ===" << std::endl;
+    MemoryAccounting::report(std::cout);
+}
@@ -0,0 +1,368 @@
+#include "CommandServer.h"
+#include <iostream>
+
+#ifdef __linux__
+#include "batch/CommandProcessor.h"
+#include "database/FoodFileWatcher.h"
+#include "utils/FileHandler.h"
+#include "utils/Tracer.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+const size_t MAX_FRAME = 1 << 20;                         // Longest request accepted
+const std::chrono::milliseconds SAVE_INTERVAL(1000);      // Minimum time between background saves
+const int POLL_TIMEOUT_MS = 200;
+
+bool sendAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+uint32_t readLength(const std::string &buffer) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(buffer.data());
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+}
+
+} // namespace
+
+CommandServer::CommandServer(FoodDatabase &db, LogManager &logManager, DietGoalProfile &profile, ThreadPool &pool,
+                             FoodFileWatcher *watcher)
+    : m_db(db), m_logManager(logManager), m_profile(profile), m_pool(pool), m_watcher(watcher),
+      m_lastSave(std::chrono::steady_clock::now()), m_wakePipe{-1, -1} {}
+
+CommandServer::~CommandServer() {
+    for (const auto &[fd, connection] : m_connections) {
+        close(fd);
+    }
+    for (int fd : m_wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+size_t CommandServer::requestsServed() const {
+    return m_requests.load();
+}
+
+bool CommandServer::run(const std::string &socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    // A socket left behind by a previous run would make bind fail
+    struct stat info;
+    if (stat(socketPath.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(socketPath.c_str());
+    }
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(listenFd, SOMAXCONN) < 0) {
+        std::cerr << "Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (listenFd >= 0) {
+            close(listenFd);
+        }
+        return false;
+    }
+
+    // Shutdown signals are read from a signalfd. They must be blocked in every thread for
+    // that, so the caller blocks them before starting the pool's threads.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    int signalFd = signalfd(-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+
+    if (signalFd < 0 || pipe2(m_wakePipe, O_CLOEXEC | O_NONBLOCK) < 0) {
+        std::cerr << "Could not set up the server: " << std::strerror(errno) << std::endl;
+        close(listenFd);
+        if (signalFd >= 0) {
+            close(signalFd);
+        }
+        return false;
+    }
+
+    std::cout << "Serving on " << socketPath << " with " << m_pool.size() << " threads (Ctrl+C to stop)." << std::endl;
+
+    bool running = true;
+    std::vector<pollfd> fds;
+    while (running) {
+        fds.clear();
+        fds.push_back({listenFd, POLLIN, 0});
+        fds.push_back({signalFd, POLLIN, 0});
+        fds.push_back({m_wakePipe[0], POLLIN, 0});
+        if (m_watcher) {
+            fds.push_back({m_watcher->descriptor(), POLLIN, 0});
+        }
+        const size_t firstConnection = fds.size();
+        for (const auto &[fd, connection] : m_connections) {
+            if (!connection->busy) {
+                fds.push_back({fd, POLLIN, 0});
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), POLL_TIMEOUT_MS) < 0 && errno != EINTR) {
+            std::cerr << "poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            running = false;
+        }
+
+        // Connections whose response has been sent can take their next request
+        if (fds[2].revents & POLLIN) {
+            char drain[64];
+            while (read(m_wakePipe[0], drain, sizeof(drain)) > 0) {
+            }
+            std::vector<int> finished;
+            {
+                std::lock_guard<std::mutex> lock(m_finishedMutex);
+                finished.swap(m_finished);
+            }
+            for (int fd : finished) {
+                auto it = m_connections.find(fd);
+                it->second->busy = false;
+                if (!dispatch(*it->second)) {
+                    close(fd);
+                    m_connections.erase(it);
+                }
+            }
+        }
+
+        if (m_watcher && (fds[3].revents & POLLIN)) {
+            reloadFoods();
+        }
+
+        for (size_t i = firstConnection; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            auto it = m_connections.find(fds[i].fd);
+            if (!receive(*it->second)) {
+                close(fds[i].fd);
+                m_connections.erase(it);
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC)) >= 0) {
+                // A client that stops reading must not hold a pool thread forever
+                timeval timeout{5, 0};
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                m_connections[fd] = std::make_unique<Connection>(fd);
+            }
+        }
+
+        maybeSave(false);
+    }
+
+    // Let running requests finish, then write everything that changed
+    close(listenFd);
+    unlink(socketPath.c_str());
+    m_pool.wait();
+    if (m_watcher) {
+        // Take in an edit that arrived since the last poll, so the final save keeps it
+        reloadFoods();
+    }
+    maybeSave(true);
+    m_pool.wait();
+    close(signalFd);
+    return true;
+}
+
+bool CommandServer::receive(Connection &connection) {
+    char buffer[64 * 1024];
+    ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+        return received < 0 && (errno == EINTR || errno == EAGAIN);
+    }
+    connection.input.append(buffer, static_cast<size_t>(received));
+    return dispatch(connection);
+}
+
+bool CommandServer::dispatch(Connection &connection) {
+    if (connection.busy || connection.input.size() < 4) {
+        return true;
+    }
+    uint32_t length = readLength(connection.input);
+    if (length > MAX_FRAME) {
+        return false;
+    }
+    if (connection.input.size() < 4 + length) {
+        return true;
+    }
+
+    std::string request = connection.input.substr(4, length);
+    connection.input.erase(0, 4 + length);
+    connection.busy = true;
+
+    int fd = connection.fd;
+    m_pool.submit([this, fd, request = std::move(request)]() { serve(fd, request); });
+    return true;
+}
+
+void CommandServer::serve(int fd, const std::string &request) {
+    std::string response;
+    try {
+        CommandProcessor processor(m_db, m_logManager, m_profile);
+        if (CommandProcessor::isReadOnly(request)) {
+            std::shared_lock<std::shared_mutex> lock(m_dataLock);
+            processor.execute(request, response);
+        } else {
+            std::string_view command = CommandProcessor::commandOf(request);
+            if (command == "save") {
+                // Same path as the background saves, so their writes never overlap
+                response = save() ? "ok\n" : "error: could not save\n";
+            } else {
+                std::unique_lock<std::shared_mutex> lock(m_dataLock);
+                if (processor.execute(request, response)) {
+                    (command == "food" ? m_foodsChanged : m_logsChanged).store(true);
+                }
+            }
+        }
+    } catch (const std::exception &e) {
+        response = std::string("error: ") + e.what() + "\n";
+    }
+
+    char header[4] = {char(response.size() >> 24), char(response.size() >> 16), char(response.size() >> 8),
+                      char(response.size())};
+    sendAll(fd, header, sizeof(header)) && sendAll(fd, response.data(), response.size());
+    ++m_requests;
+
+    {
+        std::lock_guard<std::mutex> lock(m_finishedMutex);
+        m_finished.push_back(fd);
+    }
+    wake();
+}
+
+void CommandServer::maybeSave(bool force) {
+    if (!m_foodsChanged.load() && !m_logsChanged.load()) {
+        return;
+    }
+    if (!force && std::chrono::steady_clock::now() - m_lastSave < SAVE_INTERVAL) {
+        return;
+    }
+    if (m_saveQueued.exchange(true)) {
+        return;
+    }
+    m_lastSave = std::chrono::steady_clock::now();
+    m_pool.submit([this]() {
+        m_saveQueued.store(false);
+        if (!save()) {
+            std::cerr << "Warning: Background save failed; will retry." << std::endl;
+        }
+    });
+}
+
+bool CommandServer::save() {
+    TRACE_SCOPE("CommandServer::save");
+    std::lock_guard<std::mutex> saveLock(m_saveMutex);
+    bool foods = m_foodsChanged.exchange(false);
+    bool logs = m_logsChanged.exchange(false);
+
+    std::string basicFoods, compositeFoods, dailyLogs;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_dataLock);
+        if (foods) {
+            basicFoods = m_db.serializeBasicFoods();
+            compositeFoods = m_db.serializeCompositeFoods();
+            if (m_watcher) {
+                // Recorded before writing, so the watcher doesn't reload our own save.
+                // reloadFoods takes the lock exclusively, so it can't run in between.
+                m_watcher->noteWrite(m_db.getBasicFoodFilePath(), basicFoods);
+                m_watcher->noteWrite(m_db.getCompositeFoodFilePath(), compositeFoods);
+            }
+        }
+        if (logs) {
+            dailyLogs = m_logManager.serializeLogs();
+        }
+    }
+
+    // Disk I/O happens outside the data lock, so requests keep flowing meanwhile
+    FileHandler::GroupCommit group;
+    bool ok = true;
+    if (foods) {
+        ok = FileHandler::writeFileAtomically(m_db.getBasicFoodFilePath(), basicFoods) && ok;
+        ok = FileHandler::writeFileAtomically(m_db.getCompositeFoodFilePath(), compositeFoods) && ok;
+    }
+    if (logs) {
+        ok = FileHandler::writeFileAtomically(m_logManager.getLogFilePath(), dailyLogs) && ok;
+    }
+    ok = group.commit() && ok;
+
+    if (!ok) {
+        // Try again on the next round
+        if (foods) {
+            m_foodsChanged.store(true);
+        }
+        if (logs) {
+            m_logsChanged.store(true);
+        }
+    }
+    return ok;
+}
+
+void CommandServer::reloadFoods() {
+    std::unique_lock<std::shared_mutex> lock(m_dataLock);
+    size_t changed = m_watcher->poll();
+    if (changed > 0) {
+        // Foods may have been re-priced, so refresh the per-day totals
+        m_logManager.rebuildCalorieTotals();
+        std::cout << "Reloaded " << changed << " changed foods from disk." << std::endl;
+    }
+}
+
+void CommandServer::wake() {
+    char byte = 1;
+    ssize_t written = write(m_wakePipe[1], &byte, 1);
+    (void)written; // A full pipe already guarantees a wakeup
+}
+
+#else
+
+// signalfd, accept4 and pipe2 are Linux-only; elsewhere --serve reports that serving is unavailable
+CommandServer::CommandServer(FoodDatabase &db, LogManager &logManager, DietGoalProfile &profile, ThreadPool &pool,
+                             FoodFileWatcher *watcher)
+    : m_db(db), m_logManager(logManager), m_profile(profile), m_pool(pool), m_watcher(watcher), m_wakePipe{-1, -1} {}
+
+CommandServer::~CommandServer() {}
+
+size_t CommandServer::requestsServed() const {
+    return 0;
+}
+
+bool CommandServer::run(const std::string &) {
+    std::cerr << "Serving over a Unix domain socket is not supported on this platform" << std::endl;
+    return false;
+}
+
+#endif // __linux__
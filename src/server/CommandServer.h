@@ -0,0 +1,100 @@
+#ifndef COMMAND_SERVER_H
+#define COMMAND_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "database/FoodDatabase.h"
+#include "daily_log/DailyLog.h"
+#include "diet_goal/DietGoalProfile.h"
+#include "utils/ThreadPool.h"
+
+class FoodFileWatcher;
+
+// Serves CommandProcessor commands to local clients over a Unix domain socket.
+//
+// Every request and response is a frame: a 4-byte big-endian length followed by that
+// many bytes. A request holds one command line (see CommandProcessor); the response
+// holds its output, ending in "ok" or "error: <reason>". A client may pipeline
+// requests; each connection's responses come back in order.
+//
+// One I/O thread accepts connections and reads frames; each complete request runs on
+// the thread pool. Read-only commands share a reader/writer lock, so lookups and
+// searches run in parallel, while changes take it exclusively. Changed data is saved in
+// the background about once a second, and on shutdown (SIGINT or SIGTERM). Given a
+// FoodFileWatcher, the I/O thread also reloads food files edited by someone else.
+class CommandServer
+{
+public:
+    CommandServer(FoodDatabase &db, LogManager &logManager, DietGoalProfile &profile, ThreadPool &pool,
+                  FoodFileWatcher *watcher = nullptr);
+    ~CommandServer();
+
+    CommandServer(const CommandServer &) = delete;
+    CommandServer &operator=(const CommandServer &) = delete;
+
+    // Listen on socketPath and serve until SIGINT or SIGTERM; false if the socket can't be set up
+    bool run(const std::string &socketPath);
+
+    // Requests answered so far
+    size_t requestsServed() const;
+
+private:
+    struct Connection
+    {
+        explicit Connection(int fd) : fd(fd) {}
+
+        int fd;
+        std::string input;  // Bytes received but not yet dispatched
+        bool busy = false;  // A request of this connection is running on the pool
+    };
+
+    // Read what the socket has and dispatch the next request; false if the connection is done
+    bool receive(Connection &connection);
+
+    // Run the next complete request of an idle connection on the pool; false on a bad frame
+    bool dispatch(Connection &connection);
+
+    // Run one command under the right lock and send the response (pool thread)
+    void serve(int fd, const std::string &request);
+
+    // Queue a background save if something changed and the last save is old enough
+    void maybeSave(bool force);
+
+    // Serialize the changed files under a shared lock and write them as one group commit
+    bool save();
+
+    // Apply outside edits of the food files under the exclusive lock (I/O thread)
+    void reloadFoods();
+
+    // Wake the I/O thread from a pool thread
+    void wake();
+
+    FoodDatabase &m_db;
+    LogManager &m_logManager;
+    DietGoalProfile &m_profile;
+    ThreadPool &m_pool;
+    FoodFileWatcher *m_watcher;  // May be null
+
+    std::shared_mutex m_dataLock;  // Readers share, changes are exclusive
+    std::mutex m_saveMutex;        // One save at a time, so temporary files don't collide
+    std::atomic<bool> m_foodsChanged{false};
+    std::atomic<bool> m_logsChanged{false};
+    std::atomic<bool> m_saveQueued{false};
+    std::chrono::steady_clock::time_point m_lastSave;
+
+    std::unordered_map<int, std::unique_ptr<Connection>> m_connections; // I/O thread only
+    std::mutex m_finishedMutex;
+    std::vector<int> m_finished;  // Connections whose request completed, for the I/O thread
+    int m_wakePipe[2];            // Written by pool threads to interrupt poll()
+    std::atomic<size_t> m_requests{0};
+};
+
+#endif // COMMAND_SERVER_H
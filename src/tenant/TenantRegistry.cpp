@@ -0,0 +1,267 @@
+#include "TenantRegistry.h"
+#include "utils/FileHandler.h"
+#include "utils/Tracer.h"
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+// TenantSession Implementation
+TenantSession::TenantSession(const std::string& userId, const std::string& directory)
+    : m_userId(userId), m_directory(directory) {}
+
+const std::string& TenantSession::getUserId() const { return m_userId; }
+const std::string& TenantSession::getDirectory() const { return m_directory; }
+LogManager& TenantSession::getLogManager() { return *m_logManager; }
+DietGoalProfile& TenantSession::getProfile() { return *m_profile; }
+
+void TenantSession::open(FoodDatabase& db) {
+    TRACE_SCOPE("TenantSession::open");
+    if (m_logManager) {
+        return;
+    }
+
+    // <root>/<xx>/<userId>: create each level that is missing
+    size_t slash = m_directory.rfind('/');
+    size_t parentSlash = m_directory.rfind('/', slash - 1);
+    FileHandler::createDirectoryIfNotExists(m_directory.substr(0, parentSlash));
+    FileHandler::createDirectoryIfNotExists(m_directory.substr(0, slash));
+    FileHandler::createDirectoryIfNotExists(m_directory);
+
+    auto logManager = std::make_unique<LogManager>(m_directory + "/daily_logs.txt");
+    logManager->loadLogs(db);
+
+    // Loading a missing profile would prompt for one, so leave that to the interactive menu
+    std::string profilePath = m_directory + "/diet_profile.txt";
+    auto profile = std::make_unique<DietGoalProfile>(profilePath);
+    if (FileHandler::fileExists(profilePath)) {
+        try {
+            profile->loadFromFile();
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: Could not load diet profile for " << m_userId << ": " << e.what() << std::endl;
+            profile = std::make_unique<DietGoalProfile>(profilePath);
+        }
+    }
+
+    m_logManager = std::move(logManager);
+    m_profile = std::move(profile);
+}
+
+bool TenantSession::save() {
+    TRACE_SCOPE("TenantSession::save");
+    if (!m_logManager) {
+        return true;
+    }
+    try {
+        FileHandler::GroupCommit group;
+        return m_logManager->saveLogs() && m_profile->saveToFile() && group.commit();
+    } catch (const std::exception& e) {
+        std::cerr << "Error saving data for " << m_userId << ": " << e.what() << std::endl;
+        return false;
+    }
+}
+
+size_t TenantSession::estimateMemoryUsage() const {
+    size_t bytes = sizeof(TenantSession) + m_userId.capacity() + m_directory.capacity();
+    if (m_logManager) {
+        bytes += m_logManager->estimateMemoryUsage() + sizeof(DietGoalProfile);
+    }
+    return bytes;
+}
+
+// TenantHandle Implementation
+TenantHandle::TenantHandle() : m_registry(nullptr) {}
+
+TenantHandle::TenantHandle(TenantRegistry* registry, std::shared_ptr<TenantSession> session)
+    : m_registry(registry), m_session(std::move(session)), m_lock(m_session->m_mutex) {}
+
+TenantHandle::TenantHandle(TenantHandle&& other) noexcept
+    : m_registry(other.m_registry), m_session(std::move(other.m_session)), m_lock(std::move(other.m_lock)) {
+    other.m_registry = nullptr;
+}
+
+TenantHandle& TenantHandle::operator=(TenantHandle&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_registry = other.m_registry;
+        m_session = std::move(other.m_session);
+        m_lock = std::move(other.m_lock);
+        other.m_registry = nullptr;
+    }
+    return *this;
+}
+
+TenantHandle::~TenantHandle() {
+    release();
+}
+
+void TenantHandle::release() {
+    if (!m_session) {
+        return;
+    }
+
+    // Measure while the session is still locked, but charge the registry after letting go,
+    // so the shard lock is never taken while holding a session lock
+    size_t bytes = m_session->estimateMemoryUsage();
+    std::string userId = m_session->getUserId();
+    const TenantSession* session = m_session.get();
+    m_lock.unlock();
+    m_session.reset();
+
+    if (m_registry) {
+        m_registry->charge(userId, session, bytes);
+    }
+}
+
+// TenantRegistry Implementation
+TenantRegistry::TenantRegistry(FoodDatabase& db, const std::string& rootDirectory,
+                               size_t memoryBudget, size_t shardCount)
+    : m_db(db), m_root(rootDirectory) {
+    if (shardCount == 0) {
+        shardCount = 1;
+    }
+    m_shardBudget = memoryBudget / shardCount;
+    for (size_t i = 0; i < shardCount; ++i) {
+        m_shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+bool TenantRegistry::isValidUserId(const std::string& userId) {
+    if (userId.empty() || userId.size() > 64 || userId == "." || userId == "..") {
+        return false;
+    }
+    for (char c : userId) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.') {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t TenantRegistry::hashUserId(const std::string& userId) {
+    // 64-bit FNV-1a, so directory placement does not depend on the standard library
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : userId) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+std::string TenantRegistry::userDirectory(const std::string& userId) const {
+    char bucket[4];
+    std::snprintf(bucket, sizeof(bucket), "%02x", static_cast<unsigned>(hashUserId(userId) & 0xff));
+    return m_root + "/" + bucket + "/" + userId;
+}
+
+TenantRegistry::Shard& TenantRegistry::shardFor(const std::string& userId) const {
+    // Use the high bits so shards are independent of the directory bucket
+    return *m_shards[(hashUserId(userId) >> 8) % m_shards.size()];
+}
+
+TenantHandle TenantRegistry::acquire(const std::string& userId) {
+    if (!isValidUserId(userId)) {
+        throw std::invalid_argument("Invalid user ID: " + userId);
+    }
+
+    std::shared_ptr<TenantSession> session;
+    {
+        Shard& shard = shardFor(userId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.residents.find(userId);
+        if (it == shard.residents.end()) {
+            shard.lru.push_front(userId);
+            Resident resident{std::make_shared<TenantSession>(userId, userDirectory(userId)), 0, shard.lru.begin()};
+            it = shard.residents.emplace(userId, std::move(resident)).first;
+        } else {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lruPosition);
+        }
+        session = it->second.session;
+    }
+
+    // Make room now that this session counts as in use
+    evictIdle(shardFor(userId));
+
+    // Loading happens under the session's own lock, so other users are not held up
+    TenantHandle handle(this, std::move(session));
+    handle->open(m_db);
+    return handle;
+}
+
+void TenantRegistry::charge(const std::string& userId, const TenantSession* session, size_t bytes) {
+    Shard& shard = shardFor(userId);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.residents.find(userId);
+        if (it == shard.residents.end() || it->second.session.get() != session) {
+            return;
+        }
+        shard.bytes = shard.bytes - it->second.bytes + bytes;
+        it->second.bytes = bytes;
+    }
+    evictIdle(shard);
+}
+
+void TenantRegistry::evictIdle(Shard& shard) {
+    // Pick the victims under the shard lock, but save them after letting it go, so a slow
+    // disk does not hold up every other user of the shard. Each victim stays locked until
+    // it is dropped: anyone acquiring it meanwhile waits, and nobody can change it unsaved.
+    std::vector<std::pair<std::shared_ptr<TenantSession>, std::unique_lock<std::mutex>>> victims;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size_t bytes = shard.bytes;
+        for (auto position = shard.lru.rbegin(); bytes > m_shardBudget && position != shard.lru.rend(); ++position) {
+            Resident& resident = shard.residents.find(*position)->second;
+
+            // Only the registry holds idle sessions, so nobody else can be using this one
+            if (resident.session.use_count() > 1) {
+                continue;
+            }
+            // Never wait on a session lock here; that would invert the handles' lock order
+            std::unique_lock<std::mutex> sessionLock(resident.session->m_mutex, std::try_to_lock);
+            if (!sessionLock) {
+                continue;
+            }
+            bytes -= resident.bytes;
+            victims.emplace_back(resident.session, std::move(sessionLock));
+        }
+    }
+
+    for (auto& [session, sessionLock] : victims) {
+        if (!session->save()) {
+            continue; // Keep unsaved data in memory rather than lose it
+        }
+
+        // Anyone who acquired the session during the save is waiting for it; keep it for them
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.residents.find(session->getUserId());
+        if (it == shard.residents.end() || it->second.session != session || session.use_count() > 2) {
+            continue;
+        }
+        shard.bytes -= it->second.bytes;
+        shard.lru.erase(it->second.lruPosition);
+        shard.residents.erase(it);
+    }
+}
+
+size_t TenantRegistry::residentCount() const {
+    size_t count = 0;
+    for (const auto& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->residents.size();
+    }
+    return count;
+}
+
+size_t TenantRegistry::memoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        bytes += shard->bytes;
+    }
+    return bytes;
+}
@@ -0,0 +1,137 @@
+#ifndef TENANT_REGISTRY_H
+#define TENANT_REGISTRY_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "database/FoodDatabase.h"
+#include "daily_log/DailyLog.h"
+#include "diet_goal/DietGoalProfile.h"
+
+// One user's daily logs and diet profile, stored in that user's directory
+class TenantSession
+{
+public:
+    TenantSession(const std::string &userId, const std::string &directory);
+
+    const std::string &getUserId() const;
+    const std::string &getDirectory() const;
+
+    // Only valid once the session has been opened
+    LogManager &getLogManager();
+    DietGoalProfile &getProfile();
+
+    // Save the logs and, if it was loaded, the profile
+    bool save();
+
+    // Rough number of bytes held by the session
+    size_t estimateMemoryUsage() const;
+
+private:
+    friend class TenantRegistry;
+    friend class TenantHandle;
+
+    // Create the directory and load the user's files on first use
+    void open(FoodDatabase &db);
+
+    std::string m_userId;
+    std::string m_directory;
+    std::unique_ptr<LogManager> m_logManager;
+    std::unique_ptr<DietGoalProfile> m_profile;
+    std::mutex m_mutex; // Serializes all work on this user
+};
+
+class TenantRegistry;
+
+// Exclusive access to an open session; the session stays resident while a handle exists
+class TenantHandle
+{
+public:
+    TenantHandle();
+    TenantHandle(TenantHandle &&other) noexcept;
+    TenantHandle &operator=(TenantHandle &&other) noexcept;
+    ~TenantHandle();
+
+    TenantSession *operator->() const { return m_session.get(); }
+    TenantSession &operator*() const { return *m_session; }
+    explicit operator bool() const { return m_session != nullptr; }
+
+    // Give up access and report the session's current size to the registry
+    void release();
+
+private:
+    friend class TenantRegistry;
+    TenantHandle(TenantRegistry *registry, std::shared_ptr<TenantSession> session);
+
+    TenantRegistry *m_registry;
+    std::shared_ptr<TenantSession> m_session;
+    std::unique_lock<std::mutex> m_lock;
+};
+
+// Serves many users from one process. All users share one FoodDatabase; each user's
+// session is opened lazily from <root>/<xx>/<userId>/ and kept in one of several shards,
+// each with its own lock and LRU list. When a shard exceeds its share of the memory
+// budget, its least recently used idle sessions are saved and evicted.
+class TenantRegistry
+{
+public:
+    TenantRegistry(FoodDatabase &db, const std::string &rootDirectory,
+                   size_t memoryBudget = 64 * 1024 * 1024, size_t shardCount = 16);
+
+    // Open (or reuse) a user's session and lock it for the caller; throws std::invalid_argument
+    // for user IDs that are not safe directory names
+    TenantHandle acquire(const std::string &userId);
+
+    // Check that a user ID only uses letters, digits, '-', '_' and '.'
+    static bool isValidUserId(const std::string &userId);
+
+    // Directory that holds a user's files
+    std::string userDirectory(const std::string &userId) const;
+
+    // Number of sessions currently in memory
+    size_t residentCount() const;
+
+    // Estimated bytes held by resident sessions
+    size_t memoryUsage() const;
+
+private:
+    friend class TenantHandle;
+
+    struct Resident
+    {
+        std::shared_ptr<TenantSession> session;
+        size_t bytes;                           // Last reported size
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Resident> residents;
+        std::list<std::string> lru; // Most recently used first
+        size_t bytes = 0;
+    };
+
+    // Stable hash of a user ID, used for both shard and directory placement
+    static size_t hashUserId(const std::string &userId);
+
+    Shard &shardFor(const std::string &userId) const;
+
+    // Record a released session's size, then evict if the shard is over budget
+    void charge(const std::string &userId, const TenantSession *session, size_t bytes);
+
+    // Save and drop idle sessions from the LRU end; takes the shard lock itself, and saves
+    // after releasing it
+    void evictIdle(Shard &shard);
+
+    FoodDatabase &m_db;
+    std::string m_root;
+    size_t m_shardBudget; // Memory budget per shard
+    std::vector<std::unique_ptr<Shard>> m_shards;
+};
+
+#endif // TENANT_REGISTRY_H
@@ -0,0 +1,67 @@
+#include "DateUtils.h"
+#include <cctype>
+#include <cstdio>
+
+namespace {
+
+// Days in a month of the proleptic Gregorian calendar
+int daysInMonth(int year, int month) {
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leap ? 29 : days[month - 1];
+}
+
+} // namespace
+
+bool DateUtils::toDayNumber(std::string_view date, int& dayNumber) {
+    if (date.size() != 10 || date[2] != '-' || date[5] != '-') {
+        return false;
+    }
+    for (size_t i = 0; i < date.size(); ++i) {
+        if (i != 2 && i != 5 && !std::isdigit(static_cast<unsigned char>(date[i]))) {
+            return false;
+        }
+    }
+
+    auto number = [&date](size_t start, size_t length) {
+        int value = 0;
+        for (size_t i = start; i < start + length; ++i) {
+            value = value * 10 + (date[i] - '0');
+        }
+        return value;
+    };
+    int day = number(0, 2);
+    int month = number(3, 2);
+    int year = number(6, 4);
+
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) {
+        return false;
+    }
+
+    // Days from civil date (shift the year to start in March so leap days fall last)
+    int y = month <= 2 ? year - 1 : year;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yearOfEra = y - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    dayNumber = era * 146097 + dayOfEra - 719468;
+    return true;
+}
+
+std::string DateUtils::fromDayNumber(int dayNumber) {
+    // Civil date from days (inverse of toDayNumber)
+    int z = dayNumber + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int dayOfEra = z - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthIndex = (5 * dayOfYear + 2) / 153;
+    int day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    int month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    int year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+    // Sized for any int in every field, so the output can never be cut short
+    char buffer[3 * 11 + 2 + 1];
+    std::snprintf(buffer, sizeof(buffer), "%02d-%02d-%04d", day, month, year);
+    return buffer;
+}
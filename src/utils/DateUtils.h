@@ -0,0 +1,28 @@
+#ifndef DATE_UTILS_H
+#define DATE_UTILS_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Utility class for converting between DD-MM-YYYY dates and day numbers
+ */
+class DateUtils {
+public:
+    /**
+     * @brief Convert a DD-MM-YYYY date to a day number
+     * @param date The date string
+     * @param dayNumber Set to the number of days since 01-01-1970
+     * @return true if the date was well-formed, false otherwise
+     */
+    static bool toDayNumber(std::string_view date, int& dayNumber);
+
+    /**
+     * @brief Convert a day number to a DD-MM-YYYY date
+     * @param dayNumber Number of days since 01-01-1970
+     * @return The date string
+     */
+    static std::string fromDayNumber(int dayNumber);
+};
+
+#endif // DATE_UTILS_H
@@ -1,7 +1,154 @@
 #include "FileHandler.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
+#include <set>
 #include <sys/stat.h>
 #include <iostream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// A temporary file waiting to replace its target
+struct StagedWrite {
+    std::string targetPath;
+    std::string tempPath;
+    int fd; // Still open so it can be flushed at commit (-1 where unused)
+};
+
+// Writes staged by the GroupCommit scopes of this thread
+struct Batch {
+    int depth = 0;
+    std::vector<StagedWrite> writes;
+};
+
+thread_local Batch batch;
+
+std::string directoryOf(const std::string& filePath) {
+    size_t slash = filePath.rfind('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : filePath.substr(0, slash);
+}
+
+// Write contents to a temporary file, keeping the target's permissions
+bool writeTemp(const std::string& targetPath, const std::string& contents, StagedWrite& staged) {
+    staged.targetPath = targetPath;
+    staged.fd = -1;
+#ifdef _WIN32
+    staged.tempPath = targetPath + ".tmp";
+    std::ofstream file(staged.tempPath, std::ios::binary | std::ios::trunc);
+    return file.write(contents.data(), contents.size()) && file.flush();
+#else
+    // A unique name, so processes saving the same file never write into each other's temp file
+    std::string name = targetPath + ".XXXXXX";
+    int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+        return false;
+    }
+    staged.tempPath = name;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    struct stat info;
+    mode_t mode = stat(targetPath.c_str(), &info) == 0 ? (info.st_mode & 07777) : 0644;
+    if (fchmod(fd, mode) != 0) {
+        close(fd);
+        unlink(staged.tempPath.c_str());
+        return false;
+    }
+    size_t written = 0;
+    while (written < contents.size()) {
+        ssize_t count = write(fd, contents.data() + written, contents.size() - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            close(fd);
+            unlink(staged.tempPath.c_str());
+            return false;
+        }
+        written += static_cast<size_t>(count);
+    }
+    staged.fd = fd;
+    return true;
+#endif
+}
+
+void discard(const StagedWrite& staged) {
+#ifndef _WIN32
+    if (staged.fd >= 0) {
+        close(staged.fd);
+    }
+#endif
+    std::remove(staged.tempPath.c_str());
+}
+
+// Flush every staged file, and only if all of them reached the disk rename them into place
+// in order, stopping at the first failure; then flush each directory once so the renames
+// are durable too. Renames of separate files can't be made atomic together: a failure part
+// way leaves the earlier targets replaced and the later ones untouched.
+bool commitWrites(std::vector<StagedWrite>& writes) {
+    bool success = true;
+
+#ifdef __linux__
+    // Start writing every file back before waiting on any, so the flushes overlap and the
+    // later fsyncs mostly find their data already on its way to the disk
+    for (const auto& staged : writes) {
+        sync_file_range(staged.fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+    }
+#endif
+#ifndef _WIN32
+    for (auto& staged : writes) {
+        if (success && fsync(staged.fd) != 0) {
+            std::cerr << "Could not flush file: " << staged.targetPath << std::endl;
+            success = false;
+        }
+        close(staged.fd);
+        staged.fd = -1;
+    }
+#endif
+
+    std::set<std::string> directories;
+    size_t renamed = 0;
+    for (; success && renamed < writes.size(); ++renamed) {
+        std::error_code error;
+        std::filesystem::rename(writes[renamed].tempPath, writes[renamed].targetPath, error);
+        if (error) {
+            success = false;
+            break;
+        }
+        directories.insert(directoryOf(writes[renamed].targetPath));
+    }
+    for (size_t i = renamed; i < writes.size(); ++i) {
+        std::cerr << "Could not save file: " << writes[i].targetPath << std::endl;
+        discard(writes[i]);
+    }
+
+#ifndef _WIN32
+    for (const auto& directory : directories) {
+        int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0 || fsync(fd) != 0) {
+            success = false;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+
+    writes.clear();
+    return success;
+}
+
+} // namespace
 
 bool FileHandler::fileExists(const std::string& filePath) {
     struct stat buffer;
@@ -9,6 +156,7 @@ bool FileHandler::fileExists(const std::string& filePath) {
 }
 
 bool FileHandler::createDirectoryIfNotExists(const std::string& dirPath) {
+    TRACE_SCOPE("FileHandler::createDirectoryIfNotExists");
     struct stat info;
     
     // Check if the directory already exists
@@ -31,6 +179,18 @@ bool FileHandler::createDirectoryIfNotExists(const std::string& dirPath) {
     }
 }
 
+std::vector<std::string> FileHandler::listDirectories(const std::string& dirPath) {
+    std::vector<std::string> names;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(dirPath, error), end; !error && it != end; it.increment(error)) {
+        if (it->is_directory(error)) {
+            names.push_back(it->path().filename().string());
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
 std::vector<std::string> FileHandler::readAllLines(const std::string& filePath) {
     std::vector<std::string> lines;
     std::ifstream file(filePath);
@@ -49,16 +209,60 @@ std::vector<std::string> FileHandler::readAllLines(const std::string& filePath)
 }
 
 bool FileHandler::writeAllLines(const std::string& filePath, const std::vector<std::string>& lines) {
-    std::ofstream file(filePath);
-    
-    if (!file) {
+    std::string contents;
+    for (const auto& line : lines) {
+        contents += line;
+        contents += '\n';
+    }
+    return writeFileAtomically(filePath, contents);
+}
+
+bool FileHandler::writeFileAtomically(const std::string& filePath, const std::string& contents) {
+    TRACE_SCOPE("FileHandler::writeFileAtomically");
+    Metrics::Timer timer(Metrics::Id::FILE_WRITE);
+    StagedWrite staged;
+    if (!writeTemp(filePath, contents, staged)) {
         std::cerr << "Could not open file for writing: " << filePath << std::endl;
         return false;
     }
-    
-    for (const auto& line : lines) {
-        file << line << std::endl;
+
+    if (batch.depth == 0) {
+        std::vector<StagedWrite> writes{staged};
+        return commitWrites(writes);
     }
-    
+
+    // A later write to the same file in this group replaces the earlier one
+    for (auto& pending : batch.writes) {
+        if (pending.targetPath == filePath) {
+            discard(pending);
+            pending = staged;
+            return true;
+        }
+    }
+    batch.writes.push_back(staged);
     return true;
+}
+
+FileHandler::GroupCommit::GroupCommit() : outermost(batch.depth == 0), finished(false) {
+    ++batch.depth;
+}
+
+FileHandler::GroupCommit::~GroupCommit() {
+    --batch.depth;
+    if (outermost) {
+        // Anything not committed leaves its target as it was
+        for (const auto& staged : batch.writes) {
+            discard(staged);
+        }
+        batch.writes.clear();
+    }
+}
+
+bool FileHandler::GroupCommit::commit() {
+    TRACE_SCOPE("FileHandler::GroupCommit::commit");
+    if (!outermost || finished) {
+        return true;
+    }
+    finished = true;
+    return commitWrites(batch.writes);
 }
\ No newline at end of file
@@ -23,6 +23,13 @@ public:
      */
     static bool createDirectoryIfNotExists(const std::string& dirPath);
     
+    /**
+     * @brief List the subdirectories of a directory
+     * @param dirPath Path to the directory
+     * @return Sorted names of the subdirectories, empty if the directory can't be read
+     */
+    static std::vector<std::string> listDirectories(const std::string& dirPath);
+
     /**
      * @brief Read all lines from a file
      * @param filePath Path to the file
@@ -37,6 +44,51 @@ public:
      * @return true if writing was successful, false otherwise
      */
     static bool writeAllLines(const std::string& filePath, const std::vector<std::string>& lines);
+
+    /**
+     * @brief Replace a file's contents so that a crash leaves either the old or the new file
+     *
+     * The contents go to a temporary file next to the target, which is flushed to disk and
+     * then renamed over the target; the directory is flushed last so the rename survives.
+     * Inside a GroupCommit the temporary file is only written, and the flush and rename
+     * happen when the group commits.
+     *
+     * @param filePath Path to the file
+     * @param contents The complete new contents
+     * @return true if the file was replaced (or, inside a group, staged) successfully
+     */
+    static bool writeFileAtomically(const std::string& filePath, const std::string& contents);
+
+    /**
+     * @brief Scope that batches atomic writes so their flushes overlap
+     *
+     * All files written with writeFileAtomically while the outermost scope is alive are
+     * flushed first; no target is replaced unless every one of them reached the disk. Each
+     * file still gets its own fsync, but on Linux writeback of all of them starts before the
+     * first is waited on, so the flushes overlap instead of running back to back. The files
+     * are then renamed in order, stopping at the first failure, and each distinct directory
+     * is flushed once. Nested scopes join the outermost one. A scope destroyed without
+     * commit() discards the staged files and leaves the targets untouched.
+     */
+    class GroupCommit {
+    public:
+        GroupCommit();
+        ~GroupCommit();
+
+        GroupCommit(const GroupCommit&) = delete;
+        GroupCommit& operator=(const GroupCommit&) = delete;
+
+        /**
+         * @brief Make every staged write durable and visible
+         * @return true if all staged files replaced their targets; always true for nested scopes.
+         *         On false, targets before the failing one may already have been replaced
+         */
+        bool commit();
+
+    private:
+        bool outermost; // Only the outermost scope commits or discards
+        bool finished;  // commit() already ran
+    };
 };
 
 #endif // FILE_HANDLER_H
\ No newline at end of file
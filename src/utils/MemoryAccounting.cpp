@@ -0,0 +1,262 @@
+#include "MemoryAccounting.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+const size_t TAG_COUNT = static_cast<size_t>(MemoryTag::COUNT);
+
+#ifdef YADA_MEMORY_ACCOUNTING
+
+/**
+ * @brief Counters of one tag; index TAG_COUNT holds the sum over all tags
+ */
+struct Counters {
+    std::atomic<std::uint64_t> currentBytes;
+    std::atomic<std::uint64_t> peakBytes;
+    std::atomic<std::uint64_t> totalBytes;
+    std::atomic<std::uint64_t> allocations;
+    std::atomic<std::uint64_t> frees;
+};
+
+// Zero-initialized before any constructor runs, so allocations during static init are safe
+Counters counters[TAG_COUNT + 1];
+
+/**
+ * @brief Stored in front of every block, so a free is credited to the right tag
+ */
+struct alignas(std::max_align_t) Header {
+    std::size_t size;
+    MemoryTag tag;
+};
+
+void raisePeak(Counters& counter, std::uint64_t current) {
+    std::uint64_t peak = counter.peakBytes.load(std::memory_order_relaxed);
+    while (current > peak && !counter.peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+}
+
+void charge(Counters& counter, std::size_t size) {
+    raisePeak(counter, counter.currentBytes.fetch_add(size, std::memory_order_relaxed) + size);
+    counter.totalBytes.fetch_add(size, std::memory_order_relaxed);
+    counter.allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void credit(Counters& counter, std::size_t size) {
+    counter.currentBytes.fetch_sub(size, std::memory_order_relaxed);
+    counter.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Allocate, retrying through the new handler like the standard operator new
+ */
+template <typename Allocate>
+void* allocateOrThrow(Allocate allocate) {
+    void* block;
+    while (!(block = allocate())) {
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+    return block;
+}
+
+/**
+ * @brief Fill in a block's header and charge it to the current tag; returns the block
+ */
+void* track(Header* header, std::size_t size) {
+    header->size = size;
+    header->tag = MemoryAccounting::currentTag();
+    charge(counters[static_cast<size_t>(header->tag)], size);
+    charge(counters[TAG_COUNT], size);
+    return header + 1;
+}
+
+/**
+ * @brief Credit a block's tag; returns its header
+ */
+Header* untrack(void* pointer) {
+    Header* header = static_cast<Header*>(pointer) - 1;
+    credit(counters[static_cast<size_t>(header->tag)], header->size);
+    credit(counters[TAG_COUNT], header->size);
+    return header;
+}
+
+static_assert((sizeof(Header) & (sizeof(Header) - 1)) == 0, "Header size must be a power of two");
+
+/**
+ * @brief Alignment of an over-aligned block, which is also the room left in front for its header
+ */
+std::size_t alignedOffset(std::align_val_t alignment) {
+    return std::max(static_cast<std::size_t>(alignment), sizeof(Header));
+}
+
+#endif // YADA_MEMORY_ACCOUNTING
+
+} // namespace
+
+#ifdef YADA_MEMORY_ACCOUNTING
+
+void* operator new(std::size_t size) {
+    void* block = allocateOrThrow([size] { return std::malloc(sizeof(Header) + size); });
+    return track(static_cast<Header*>(block), size);
+}
+
+void operator delete(void* pointer) noexcept {
+    if (!pointer) {
+        return;
+    }
+    std::free(untrack(pointer));
+}
+
+// Over-aligned types and std::pmr's new_delete_resource allocate through these; the header
+// sits just before the block, in front padding as large as the alignment
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    std::size_t offset = alignedOffset(alignment);
+    std::size_t total = (offset + size + offset - 1) / offset * offset; // aligned_alloc wants a multiple
+    void* block = allocateOrThrow([offset, total] { return std::aligned_alloc(offset, total); });
+    return track(reinterpret_cast<Header*>(static_cast<char*>(block) + offset) - 1, size);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept {
+    if (!pointer) {
+        return;
+    }
+    untrack(pointer);
+    std::free(static_cast<char*>(pointer) - alignedOffset(alignment));
+}
+
+// The remaining forms route through the four above, so every block carries a header
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete[](void* pointer) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    operator delete(pointer);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return operator new(size, alignment, std::nothrow);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept {
+    operator delete(pointer, alignment);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(pointer, alignment);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(pointer, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    operator delete(pointer, alignment);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    operator delete(pointer, alignment);
+}
+
+#endif // YADA_MEMORY_ACCOUNTING
+
+bool MemoryAccounting::isAvailable() {
+#ifdef YADA_MEMORY_ACCOUNTING
+    return true;
+#else
+    return false;
+#endif
+}
+
+MemoryAccounting::Usage MemoryAccounting::usage(MemoryTag tag) {
+    Usage usage = {};
+#ifdef YADA_MEMORY_ACCOUNTING
+    const Counters& counter = counters[tag == MemoryTag::COUNT ? TAG_COUNT : static_cast<size_t>(tag)];
+    usage.currentBytes = counter.currentBytes.load(std::memory_order_relaxed);
+    usage.peakBytes = counter.peakBytes.load(std::memory_order_relaxed);
+    usage.totalBytes = counter.totalBytes.load(std::memory_order_relaxed);
+    usage.allocations = counter.allocations.load(std::memory_order_relaxed);
+    usage.frees = counter.frees.load(std::memory_order_relaxed);
+#else
+    (void)tag;
+#endif
+    return usage;
+}
+
+const char* MemoryAccounting::name(MemoryTag tag) {
+    static const char* const names[TAG_COUNT + 1] = {"Other", "FoodDatabase", "Logs", "UndoJournal",
+                                                     "DietGoalProfile", "Total"};
+    return names[static_cast<size_t>(tag)];
+}
+
+void MemoryAccounting::report(std::ostream& out) {
+    if (!isAvailable()) {
+        out << "Memory accounting is not built in (configure with -DYADA_MEMORY_ACCOUNTING=ON)." << std::endl;
+        return;
+    }
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-18s %14s %14s %16s %12s %12s\n", "Subsystem", "Current (B)", "Peak (B)",
+                  "Allocated (B)", "Allocs", "Frees");
+    out << line;
+    // MemoryTag::COUNT stands for the sum over all tags
+    for (size_t i = 0; i <= TAG_COUNT; ++i) {
+        MemoryTag tag = static_cast<MemoryTag>(i);
+        Usage tagUsage = usage(tag);
+        std::snprintf(line, sizeof(line), "%-18s %14llu %14llu %16llu %12llu %12llu\n", name(tag),
+                      static_cast<unsigned long long>(tagUsage.currentBytes),
+                      static_cast<unsigned long long>(tagUsage.peakBytes),
+                      static_cast<unsigned long long>(tagUsage.totalBytes),
+                      static_cast<unsigned long long>(tagUsage.allocations),
+                      static_cast<unsigned long long>(tagUsage.frees));
+        out << line;
+    }
+}
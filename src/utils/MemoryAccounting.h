@@ -0,0 +1,99 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief The subsystems heap allocations are charged to
+ */
+enum class MemoryTag {
+    OTHER,          // Anything allocated outside a tagged scope
+    FOOD_DATABASE,  // Foods, indexes and the search cache
+    LOGS,           // Daily logs and their totals
+    UNDO_JOURNAL,   // Undo/redo history
+    DIET_PROFILE,   // Diet profile and its history
+    COUNT
+};
+
+/**
+ * @brief Attributes heap allocations to subsystems
+ *
+ * Built only with the YADA_MEMORY_ACCOUNTING CMake option: the global operator new and
+ * delete are then replaced to charge every allocation to the innermost Scope active on the
+ * allocating thread. A block is credited back to the tag it was charged to when it is
+ * freed, wherever that happens. Without the option, a Scope compiles to nothing.
+ */
+class MemoryAccounting {
+public:
+    /**
+     * @brief Charges the allocations of the current thread to a tag for its lifetime
+     */
+    class Scope {
+    public:
+#ifdef YADA_MEMORY_ACCOUNTING
+        explicit Scope(MemoryTag tag) : previous(current) { current = tag; }
+        ~Scope() { current = previous; }
+#else
+        explicit Scope(MemoryTag) {}
+#endif
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+#ifdef YADA_MEMORY_ACCOUNTING
+    private:
+        MemoryTag previous;  // Restored when the scope ends, so scopes nest
+#endif
+    };
+
+    /**
+     * @brief Usage of one tag since the program started
+     */
+    struct Usage {
+        std::uint64_t currentBytes;  // Requested bytes still allocated
+        std::uint64_t peakBytes;     // Highest currentBytes seen
+        std::uint64_t totalBytes;    // Requested bytes over all allocations
+        std::uint64_t allocations;
+        std::uint64_t frees;
+    };
+
+    /**
+     * @brief Check whether accounting was built in
+     * @return true if configured with YADA_MEMORY_ACCOUNTING
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief Get the usage of a tag
+     * @param tag The subsystem, or MemoryTag::COUNT for the sum over all of them
+     * @return Its usage; all zero if accounting isn't built in
+     */
+    static Usage usage(MemoryTag tag);
+
+    /**
+     * @brief Print the usage of every tag and their sum
+     * @param out Stream to print to
+     */
+    static void report(std::ostream& out);
+
+    /**
+     * @brief Get the display name of a tag
+     * @param tag The subsystem, or MemoryTag::COUNT for the sum
+     * @return Name such as "FoodDatabase"
+     */
+    static const char* name(MemoryTag tag);
+
+#ifdef YADA_MEMORY_ACCOUNTING
+    /**
+     * @brief Get the tag allocations of the calling thread are charged to
+     * @return The innermost active tag
+     */
+    static MemoryTag currentTag() { return current; }
+
+private:
+    static inline thread_local MemoryTag current = MemoryTag::OTHER;
+#endif
+};
+
+#endif // MEMORY_ACCOUNTING_H
@@ -0,0 +1,149 @@
+#include "Metrics.h"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const size_t METRIC_COUNT = static_cast<size_t>(Metrics::Id::COUNT);
+
+// Bucket i holds durations below 256ns << i; the last bucket takes everything longer (~1s+)
+const size_t BUCKET_COUNT = 23;
+const std::uint64_t FIRST_BUCKET_NANOS = 256;
+
+/**
+ * @brief One thread's counters; only the owning thread writes, reporters read
+ */
+struct Shard {
+    std::atomic<std::uint64_t> count[METRIC_COUNT];
+    std::atomic<std::uint64_t> totalNanos[METRIC_COUNT];
+    std::atomic<std::uint64_t> maxNanos[METRIC_COUNT];
+    std::atomic<std::uint64_t> buckets[METRIC_COUNT][BUCKET_COUNT];
+
+    Shard() {
+        for (size_t i = 0; i < METRIC_COUNT; ++i) {
+            count[i].store(0, std::memory_order_relaxed);
+            totalNanos[i].store(0, std::memory_order_relaxed);
+            maxNanos[i].store(0, std::memory_order_relaxed);
+            for (auto& bucket : buckets[i]) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+// Shards are kept after their thread exits, so nothing recorded is lost
+std::mutex shardsMutex;
+std::vector<std::unique_ptr<Shard>>& allShards() {
+    static std::vector<std::unique_ptr<Shard>> shards;
+    return shards;
+}
+
+Shard& localShard() {
+    thread_local Shard* shard = nullptr;
+    if (!shard) {
+        auto created = std::make_unique<Shard>();
+        shard = created.get();
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        allShards().push_back(std::move(created));
+    }
+    return *shard;
+}
+
+size_t bucketFor(std::uint64_t nanos) {
+    size_t bucket = 0;
+    for (std::uint64_t bound = FIRST_BUCKET_NANOS; nanos >= bound && bucket < BUCKET_COUNT - 1; bound <<= 1) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+// Only the owning thread writes a shard, so a plain read-modify-write is race free
+void bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+double micros(std::uint64_t nanos) {
+    return static_cast<double>(nanos) / 1000.0;
+}
+
+} // namespace
+
+void Metrics::record(Id id, std::chrono::steady_clock::duration elapsed) {
+    std::uint64_t nanos = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    size_t index = static_cast<size_t>(id);
+    Shard& shard = localShard();
+
+    bump(shard.count[index], 1);
+    bump(shard.totalNanos[index], nanos);
+    bump(shard.buckets[index][bucketFor(nanos)], 1);
+    if (nanos > shard.maxNanos[index].load(std::memory_order_relaxed)) {
+        shard.maxNanos[index].store(nanos, std::memory_order_relaxed);
+    }
+}
+
+const char* Metrics::name(Id id) {
+    static const char* const names[METRIC_COUNT] = {
+        "food.load",         "food.serialize", "food.search",    "food.query",
+        "food.lookup",       "food.composite_calories",          "log.load",
+        "log.serialize",     "log.add",        "log.remove",     "log.undo",
+        "log.redo",          "profile.load",   "profile.serialize",
+        "profile.target",    "file.write"};
+    return names[static_cast<size_t>(id)];
+}
+
+void Metrics::report(std::ostream& out) {
+    std::uint64_t count[METRIC_COUNT] = {};
+    std::uint64_t totalNanos[METRIC_COUNT] = {};
+    std::uint64_t maxNanos[METRIC_COUNT] = {};
+    std::uint64_t buckets[METRIC_COUNT][BUCKET_COUNT] = {};
+    {
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        for (const auto& shard : allShards()) {
+            for (size_t i = 0; i < METRIC_COUNT; ++i) {
+                count[i] += shard->count[i].load(std::memory_order_relaxed);
+                totalNanos[i] += shard->totalNanos[i].load(std::memory_order_relaxed);
+                std::uint64_t shardMax = shard->maxNanos[i].load(std::memory_order_relaxed);
+                maxNanos[i] = shardMax > maxNanos[i] ? shardMax : maxNanos[i];
+                for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+                    buckets[i][b] += shard->buckets[i][b].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    // Percentiles are reported as the upper bound of the bucket they fall in
+    auto percentile = [&](size_t i, double fraction) {
+        std::uint64_t target = static_cast<std::uint64_t>(fraction * static_cast<double>(count[i]));
+        std::uint64_t seen = 0;
+        for (size_t b = 0; b < BUCKET_COUNT - 1; ++b) {
+            seen += buckets[i][b];
+            if (seen > target) {
+                std::uint64_t bound = FIRST_BUCKET_NANOS << b;
+                return micros(bound < maxNanos[i] ? bound : maxNanos[i]);
+            }
+        }
+        return micros(maxNanos[i]);
+    };
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-24s %10s %12s %10s %10s %12s\n", "Operation", "Count", "Mean (us)",
+                  "p50 (us)", "p99 (us)", "Max (us)");
+    out << line;
+    bool any = false;
+    for (size_t i = 0; i < METRIC_COUNT; ++i) {
+        if (count[i] == 0) {
+            continue;
+        }
+        any = true;
+        std::snprintf(line, sizeof(line), "%-24s %10llu %12.2f %10.2f %10.2f %12.2f\n", name(static_cast<Id>(i)),
+                      static_cast<unsigned long long>(count[i]), micros(totalNanos[i]) / static_cast<double>(count[i]),
+                      percentile(i, 0.5), percentile(i, 0.99), micros(maxNanos[i]));
+        out << line;
+    }
+    if (!any) {
+        out << "(nothing recorded yet)" << std::endl;
+    }
+}
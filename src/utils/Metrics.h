@@ -0,0 +1,103 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+/**
+ * @brief Process-wide counters and latency histograms for the hot paths
+ *
+ * Each thread records into its own shard, so recording never contends; shards are only
+ * summed when a report is printed. Collection is off by default, and a disabled Timer
+ * costs one relaxed atomic load.
+ */
+class Metrics {
+public:
+    /**
+     * @brief The instrumented operations
+     */
+    enum class Id {
+        FOOD_LOAD,
+        FOOD_SERIALIZE,
+        FOOD_SEARCH,
+        FOOD_QUERY,
+        FOOD_LOOKUP,
+        COMPOSITE_CALORIES,
+        LOG_LOAD,
+        LOG_SERIALIZE,
+        LOG_ADD,
+        LOG_REMOVE,
+        LOG_UNDO,
+        LOG_REDO,
+        PROFILE_LOAD,
+        PROFILE_SERIALIZE,
+        PROFILE_TARGET,
+        FILE_WRITE,
+        COUNT
+    };
+
+    /**
+     * @brief Measures the lifetime of a scope and records it under an operation
+     */
+    class Timer {
+    public:
+        explicit Timer(Id id) : id(id), active(Metrics::isEnabled()) {
+            if (active) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Timer() {
+            if (active) {
+                Metrics::record(id, std::chrono::steady_clock::now() - start);
+            }
+        }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        Id id;
+        bool active;                                  // Whether collection was on at the start
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * @brief Turn collection on or off
+     * @param on Whether to collect
+     */
+    static void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+
+    /**
+     * @brief Check whether collection is on
+     * @return true if timers record
+     */
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Record one occurrence of an operation
+     * @param id The operation
+     * @param elapsed How long it took
+     */
+    static void record(Id id, std::chrono::steady_clock::duration elapsed);
+
+    /**
+     * @brief Print count, mean, percentiles and maximum of every operation seen so far
+     * @param out Stream to print to
+     */
+    static void report(std::ostream& out);
+
+    /**
+     * @brief Get the display name of an operation
+     * @param id The operation
+     * @return Name such as "log.add"
+     */
+    static const char* name(Id id);
+
+private:
+    static inline std::atomic<bool> enabled{false};
+};
+
+#endif // METRICS_H
@@ -0,0 +1,143 @@
+#include "PersistenceWorker.h"
+#include "FileHandler.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Render every file of a batch
+void render(std::map<std::string, PersistenceWorker::Serializer>& batch, std::map<std::string, std::string>& files) {
+    for (auto& [path, serializer] : batch) {
+        std::string contents;
+        if (serializer(contents)) {
+            files[path] = std::move(contents);
+        }
+    }
+}
+
+// Write rendered files as one group commit, so their flushes overlap
+bool writeFiles(const std::map<std::string, std::string>& files) {
+    if (files.empty()) {
+        return true;
+    }
+    TRACE_SCOPE("PersistenceWorker::write");
+    FileHandler::GroupCommit group;
+    bool ok = true;
+    for (const auto& [path, contents] : files) {
+        ok = FileHandler::writeFileAtomically(path, contents) && ok;
+    }
+    return group.commit() && ok;
+}
+
+} // namespace
+
+PersistenceWorker::PersistenceWorker(std::chrono::milliseconds debounce, std::chrono::milliseconds maxDelay)
+    : debounce(debounce), maxDelay(maxDelay), writing(false), lastWriteOk(true), stopping(false) {
+    thread = std::thread(&PersistenceWorker::run, this);
+}
+
+PersistenceWorker::~PersistenceWorker() {
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+}
+
+void PersistenceWorker::submit(const std::string& path, Serializer serializer) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Clock::time_point now = Clock::now();
+        if (pending.empty()) {
+            firstArrival = now;
+        }
+        lastArrival = now;
+        pending[path] = std::move(serializer);
+    }
+    changed.notify_all();
+}
+
+bool PersistenceWorker::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return !writing; });
+    if (pending.empty()) {
+        return lastWriteOk;
+    }
+    std::map<std::string, Serializer> batch;
+    batch.swap(pending);
+    writing = true;
+    lock.unlock();
+
+    // The caller owns the data, and holding the write turn keeps the worker from rendering
+    std::map<std::string, std::string> files;
+    render(batch, files);
+    bool ok = writeFiles(files);
+
+    lock.lock();
+    finishWrite(lock, batch, ok);
+    return ok;
+}
+
+void PersistenceWorker::finishWrite(std::unique_lock<std::mutex>& lock, std::map<std::string, Serializer>& batch,
+                                    bool ok) {
+    if (!ok) {
+        // Retry after another quiet period; a newer change to the same file replaces the old one
+        std::cerr << "Warning: Background save failed; will retry." << std::endl;
+        for (auto& [path, serializer] : batch) {
+            pending.emplace(path, std::move(serializer));
+        }
+        firstArrival = lastArrival = Clock::now();
+    }
+    if (!batch.empty()) {
+        lastWriteOk = ok;
+    }
+    writing = false;
+    lock.unlock();
+    changed.notify_all();
+    lock.lock();
+}
+
+void PersistenceWorker::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (pending.empty()) {
+            if (stopping) {
+                return;
+            }
+            changed.wait(lock);
+            continue;
+        }
+        Clock::time_point due = std::min(lastArrival + debounce, firstArrival + maxDelay);
+        if (!stopping && Clock::now() < due) {
+            changed.wait_until(lock, due);
+            continue;
+        }
+        lock.unlock();
+
+        std::map<std::string, Serializer> batch;
+        std::map<std::string, std::string> files;
+        {
+            // Render while the UI thread is between changes, then write without blocking it
+            std::lock_guard<std::mutex> stateLock(state);
+            lock.lock();
+            changed.wait(lock, [this] { return !writing; });
+            batch.swap(pending);
+            writing = true;
+            lock.unlock();
+            render(batch, files);
+        }
+        bool ok = writeFiles(files);
+
+        lock.lock();
+        finishWrite(lock, batch, ok);
+        if (stopping) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef PERSISTENCE_WORKER_H
+#define PERSISTENCE_WORKER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Background thread that serializes and writes files the UI thread has changed
+ *
+ * The UI thread only marks a file as changed, handing over a function that renders it; the
+ * worker keeps the newest function per file and, once no change has arrived for the debounce
+ * interval (or the oldest pending one has waited maxDelay), renders everything pending and
+ * writes it as one group commit. Rendering reads the UI's data, so it runs under
+ * stateMutex(), which the UI thread holds while it changes that data; the disk writes happen
+ * after the lock is released. The worker sleeps on a condition variable while idle.
+ */
+class PersistenceWorker {
+public:
+    /**
+     * @brief Renders a file's complete contents
+     * @return false if there is nothing to write
+     */
+    using Serializer = std::function<bool(std::string& contents)>;
+
+    /**
+     * @brief Constructor for PersistenceWorker; starts the worker thread
+     * @param debounce Quiet period after the last change before writing
+     * @param maxDelay Longest a change may wait while changes keep arriving
+     */
+    explicit PersistenceWorker(std::chrono::milliseconds debounce = std::chrono::milliseconds(500),
+                               std::chrono::milliseconds maxDelay = std::chrono::milliseconds(2000));
+
+    /**
+     * @brief Write everything still pending and stop the worker
+     */
+    ~PersistenceWorker();
+
+    PersistenceWorker(const PersistenceWorker&) = delete;
+    PersistenceWorker& operator=(const PersistenceWorker&) = delete;
+
+    /**
+     * @brief Mark a file as changed; does not serialize anything or wait on disk
+     * @param path Path to the file
+     * @param serializer Renders the file; called later, under stateMutex()
+     */
+    void submit(const std::string& path, Serializer serializer);
+
+    /**
+     * @brief Write every pending file now, on the calling thread
+     *
+     * Must be called from the thread that owns the data (the UI thread), with or without
+     * stateMutex() held.
+     * @return true if the writes succeeded
+     */
+    bool flush();
+
+    /**
+     * @brief Mutex the UI thread holds while it changes data that serializers read
+     */
+    std::mutex& stateMutex() { return state; }
+
+private:
+    std::mutex state;                             // Guards the UI's data against the serializers
+    std::mutex mutex;                             // Guards the members below
+    std::condition_variable changed;              // New work, stop request, or a write finished
+    std::map<std::string, Serializer> pending;    // Newest serializer per file
+    std::chrono::steady_clock::time_point firstArrival;
+    std::chrono::steady_clock::time_point lastArrival;
+    std::chrono::milliseconds debounce;
+    std::chrono::milliseconds maxDelay;
+    bool writing;                                 // A thread is serializing or writing a batch
+    bool lastWriteOk;                             // Outcome of the most recent write
+    bool stopping;
+    std::thread thread;
+
+    /**
+     * @brief Give up the write turn, putting back a failed batch unless newer changes replaced it
+     */
+    void finishWrite(std::unique_lock<std::mutex>& lock, std::map<std::string, Serializer>& batch, bool ok);
+
+    /**
+     * @brief Worker loop
+     */
+    void run();
+};
+
+#endif // PERSISTENCE_WORKER_H
@@ -0,0 +1,202 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+/**
+ * @brief Contiguous vector that keeps up to N items inline before it allocates
+ *
+ * Meant for short lists owned by many objects, such as the components of a recipe: the
+ * common case needs no allocation and the items sit next to their owner. Larger lists move
+ * to a buffer from the given memory resource, so objects placed in an arena keep their
+ * lists there too. Like std::pmr containers, a copy uses the default resource and
+ * assignment keeps the target's resource.
+ */
+template <typename T, std::size_t N>
+class SmallVector {
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    /**
+     * @brief Create an empty vector
+     * @param memory Resource for lists longer than N
+     */
+    explicit SmallVector(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : items(inlineData()), count(0), available(N), memory(memory) {}
+
+    SmallVector(const SmallVector& other) : SmallVector() {
+        append(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector&& other) noexcept : SmallVector(other.memory) {
+        takeFrom(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            append(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            clear();
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        clear();
+        release();
+    }
+
+    iterator begin() { return items; }
+    iterator end() { return items + count; }
+    const_iterator begin() const { return items; }
+    const_iterator end() const { return items + count; }
+    T* data() { return items; }
+    const T* data() const { return items; }
+    T& operator[](std::size_t index) { return items[index]; }
+    const T& operator[](std::size_t index) const { return items[index]; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    std::size_t capacity() const { return available; }
+
+    /**
+     * @brief Check whether the items are still stored inline
+     * @return true if no buffer has been allocated
+     */
+    bool isInline() const { return items == inlineData(); }
+
+    /**
+     * @brief Make room for at least the given number of items
+     * @param minimum Capacity wanted
+     */
+    void reserve(std::size_t minimum) {
+        if (minimum > available) {
+            grow(minimum);
+        }
+    }
+
+    /**
+     * @brief Remove all items, keeping the capacity
+     */
+    void clear() {
+        std::destroy(items, items + count);
+        count = 0;
+    }
+
+    /**
+     * @brief Construct an item before a position
+     * @param position Where the item goes; end() appends
+     * @param args Constructor arguments of the item
+     * @return The new item
+     */
+    template <typename... Args>
+    T& emplace(const_iterator position, Args&&... args) {
+        std::size_t index = static_cast<std::size_t>(position - items);
+        // Build the item first: args may refer to an item that growing or shifting moves
+        T item(std::forward<Args>(args)...);
+        if (count == available) {
+            grow(count + 1);
+        }
+        if (index == count) {
+            new (items + count) T(std::move(item));
+        } else {
+            new (items + count) T(std::move(items[count - 1]));
+            std::move_backward(items + index, items + count - 1, items + count);
+            items[index] = std::move(item);
+        }
+        ++count;
+        return items[index];
+    }
+
+    /**
+     * @brief Append an item
+     * @param args Constructor arguments of the item
+     * @return The new item
+     */
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        return emplace(end(), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Remove the item at a position
+     * @param position The item to remove
+     * @return Iterator to the item that followed it
+     */
+    iterator erase(const_iterator position) {
+        std::size_t index = static_cast<std::size_t>(position - items);
+        std::move(items + index + 1, items + count, items + index);
+        --count;
+        std::destroy_at(items + count);
+        return items + index;
+    }
+
+private:
+    T* inlineData() { return reinterpret_cast<T*>(inlineStorage); }
+    const T* inlineData() const { return reinterpret_cast<const T*>(inlineStorage); }
+
+    template <typename Iterator>
+    void append(Iterator first, Iterator last) {
+        reserve(count + static_cast<std::size_t>(std::distance(first, last)));
+        std::uninitialized_copy(first, last, items + count);
+        count += static_cast<std::size_t>(std::distance(first, last));
+    }
+
+    // Move other's items here; steals its buffer when both use the same resource
+    void takeFrom(SmallVector& other) {
+        if (!other.isInline() && other.memory == memory) {
+            release();
+            items = other.items;
+            count = other.count;
+            available = other.available;
+            other.items = other.inlineData();
+            other.count = 0;
+            other.available = N;
+            return;
+        }
+        reserve(other.count);
+        std::uninitialized_move(other.begin(), other.end(), items);
+        count = other.count;
+        other.clear();
+    }
+
+    void grow(std::size_t minimum) {
+        std::size_t newCapacity = std::max(minimum, available * 2);
+        T* buffer = static_cast<T*>(memory->allocate(newCapacity * sizeof(T), alignof(T)));
+        std::uninitialized_move(items, items + count, buffer);
+        std::destroy(items, items + count);
+        release();
+        items = buffer;
+        available = newCapacity;
+    }
+
+    // Return the allocated buffer, if any; the items must already be destroyed or moved
+    void release() {
+        if (!isInline()) {
+            memory->deallocate(items, available * sizeof(T), alignof(T));
+            items = inlineData();
+            available = N;
+        }
+    }
+
+    alignas(T) unsigned char inlineStorage[N * sizeof(T)];
+    T* items;                         // inlineStorage or an allocated buffer
+    std::size_t count;
+    std::size_t available;            // Capacity of items
+    std::pmr::memory_resource* memory; // Source of buffers beyond N items
+};
+
+#endif // SMALL_VECTOR_H
@@ -0,0 +1,57 @@
+#include "StringSearch.h"
+#include <cctype>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+std::string StringSearch::foldCase(std::string_view text) {
+    std::string folded(text);
+    for (char& c : folded) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return folded;
+}
+
+bool StringSearch::contains(std::string_view text, std::string_view pattern) {
+    return find(text, pattern) != std::string_view::npos;
+}
+
+size_t StringSearch::find(std::string_view text, std::string_view pattern, size_t from) {
+    size_t length = pattern.size();
+    if (from > text.size()) {
+        return std::string_view::npos;
+    }
+    if (length == 0) {
+        return from;
+    }
+    if (length > text.size() - from) {
+        return std::string_view::npos;
+    }
+    if (length == 1) {
+        const void* found = std::memchr(text.data() + from, pattern[0], text.size() - from);
+        return found ? static_cast<size_t>(static_cast<const char*>(found) - text.data()) : std::string_view::npos;
+    }
+
+    size_t start = from;
+#if defined(__SSE2__)
+    // Blocks of 16 start positions whose last candidate byte still lies inside the text
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[length - 1]);
+    for (; start + length - 1 + 16 <= text.size(); start += 16) {
+        __m128i firstBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + start));
+        __m128i lastBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + start + length - 1));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, firstBytes), _mm_cmpeq_epi8(last, lastBytes))));
+        while (mask != 0) {
+            size_t offset = static_cast<size_t>(__builtin_ctz(mask));
+            if (std::memcmp(text.data() + start + offset + 1, pattern.data() + 1, length - 2) == 0) {
+                return start + offset;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    return findScalar(text, pattern, start);
+}
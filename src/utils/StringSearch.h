@@ -0,0 +1,52 @@
+#ifndef STRING_SEARCH_H
+#define STRING_SEARCH_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Utility class for case folding and substring search
+ */
+class StringSearch {
+public:
+    /**
+     * @brief Lowercase ASCII letters, leaving other bytes unchanged
+     * @param text The text to fold
+     * @return The folded copy
+     */
+    static std::string foldCase(std::string_view text);
+
+    /**
+     * @brief Check whether a pattern occurs in a text
+     * @param text The text to search
+     * @param pattern The pattern; an empty pattern occurs everywhere
+     * @return true if the pattern occurs
+     */
+    static bool contains(std::string_view text, std::string_view pattern);
+
+    /**
+     * @brief Find the first occurrence of a pattern at or after a position
+     *
+     * With SSE2, 16 candidate positions are tested at once by comparing the pattern's first
+     * and last bytes, and only positions where both match are compared in full. Elsewhere
+     * this falls back to std::string_view::find.
+     * @param text The text to search
+     * @param pattern The pattern; an empty pattern occurs everywhere
+     * @param from Position to start searching at
+     * @return Position of the occurrence, or std::string_view::npos if there is none
+     */
+    static size_t find(std::string_view text, std::string_view pattern, size_t from = 0);
+
+    /**
+     * @brief Scalar version of find(), used for short tails and non-SSE2 builds
+     * @param text The text to search
+     * @param pattern The pattern
+     * @param from Position to start searching at
+     * @return Position of the occurrence, or std::string_view::npos if there is none
+     */
+    static size_t findScalar(std::string_view text, std::string_view pattern, size_t from = 0) {
+        return text.find(pattern, from);
+    }
+};
+
+#endif // STRING_SEARCH_H
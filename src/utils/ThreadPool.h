@@ -0,0 +1,87 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size pool of worker threads with work stealing
+ *
+ * Every worker owns a task deque. Workers take their own newest task first and, when
+ * they run dry, steal the oldest task of another worker, so uneven tasks (a user with
+ * years of logs next to one with a week) still keep all threads busy.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Constructor for ThreadPool
+     * @param threadCount Number of workers, or 0 for one per hardware thread
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+
+    /**
+     * @brief Finish all queued tasks and join the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task; tasks submitted from a worker go to that worker's own deque
+     * @param task The task to run
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Block until every submitted task has finished
+     * @throws The first exception thrown by a task since the last wait
+     */
+    void wait();
+
+    /**
+     * @brief Get the number of workers
+     * @return Worker count
+     */
+    size_t size() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks; // Owner takes from the back, thieves from the front
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers; // One deque per thread
+    std::vector<std::thread> threads;             // Worker threads
+    std::mutex stateMutex;                        // Guards the counters below
+    std::condition_variable workAvailable;        // Signalled when tasks are queued or on shutdown
+    std::condition_variable allDone;              // Signalled when unfinished drops to zero
+    size_t queued;                                // Tasks sitting in deques
+    size_t unfinished;                            // Tasks queued or running
+    size_t nextWorker;                            // Round-robin target for outside submissions
+    bool stopping;                                // Set by the destructor
+    std::exception_ptr firstError;                // First task failure, rethrown by wait()
+
+    /**
+     * @brief Worker loop
+     * @param index The worker's own deque
+     */
+    void run(size_t index);
+
+    /**
+     * @brief Take a task from the worker's own deque, or steal one from another
+     * @param index The worker looking for work
+     * @param task Set to the task found
+     * @return true if a task was found
+     */
+    bool take(size_t index, std::function<void()>& task);
+};
+
+#endif // THREAD_POOL_H
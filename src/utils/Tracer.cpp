@@ -0,0 +1,137 @@
+#include "Tracer.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Beyond this a thread's further spans are dropped, so a long run can't exhaust memory
+const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+struct Event {
+    const char* name;
+    std::int64_t beginNanos;  // steady_clock time since its epoch
+    std::int64_t endNanos;
+};
+
+/**
+ * @brief One thread's spans; the owner appends, finish() reads
+ */
+struct Buffer {
+    std::mutex mutex;          // Only contended while finish() copies the events out
+    std::vector<Event> events;
+    size_t dropped = 0;
+    unsigned threadId = 0;     // Small number shown as the trace's tid
+};
+
+std::mutex buffersMutex;
+std::vector<std::unique_ptr<Buffer>>& allBuffers() {
+    static std::vector<std::unique_ptr<Buffer>> buffers;
+    return buffers;
+}
+
+// Set by start() and read by finish(), both under buffersMutex
+std::string tracePath;
+std::int64_t originNanos = 0;
+
+Buffer& localBuffer() {
+    thread_local Buffer* buffer = nullptr;
+    if (!buffer) {
+        auto created = std::make_unique<Buffer>();
+        buffer = created.get();
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        created->threadId = static_cast<unsigned>(allBuffers().size() + 1);
+        allBuffers().push_back(std::move(created));
+    }
+    return *buffer;
+}
+
+std::int64_t nanosOf(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// Event names are literals from the source, but keep the output valid JSON regardless
+void appendJsonString(std::string& out, const char* text) {
+    out += '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out += '\\';
+        }
+        out += static_cast<unsigned char>(*c) < 0x20 ? ' ' : *c;
+    }
+    out += '"';
+}
+
+} // namespace
+
+void Tracer::start(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        tracePath = path;
+        originNanos = nanosOf(std::chrono::steady_clock::now());
+    }
+    localBuffer(); // Registers the caller first, so it gets tid 1
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::record(const char* name, std::chrono::steady_clock::time_point begin,
+                    std::chrono::steady_clock::time_point end) {
+    Buffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= MAX_EVENTS_PER_THREAD) {
+        ++buffer.dropped;
+        return;
+    }
+    buffer.events.push_back({name, nanosOf(begin), nanosOf(end)});
+}
+
+bool Tracer::finish() {
+    if (!enabled.exchange(false, std::memory_order_relaxed)) {
+        return true;
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"yada\"}}";
+    size_t dropped = 0;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        path = tracePath;
+        char field[160];
+        for (const auto& buffer : allBuffers()) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            std::snprintf(field, sizeof(field),
+                          ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s%u\"}}",
+                          buffer->threadId, buffer->threadId == 1 ? "main " : "worker ", buffer->threadId);
+            json += field;
+            for (const Event& event : buffer->events) {
+                // Chrome traces use microseconds; keep nanosecond precision in the fraction
+                json += ",\n{\"name\":";
+                appendJsonString(json, event.name);
+                std::snprintf(field, sizeof(field), ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                              buffer->threadId, static_cast<double>(event.beginNanos - originNanos) / 1000.0,
+                              static_cast<double>(event.endNanos - event.beginNanos) / 1000.0);
+                json += field;
+            }
+            dropped += buffer->dropped;
+            buffer->events.clear();
+            buffer->dropped = 0;
+        }
+    }
+    json += "\n]}\n";
+
+    if (dropped > 0) {
+        std::cerr << "Warning: " << dropped << " trace events were dropped (per-thread limit reached)." << std::endl;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(json.data(), static_cast<std::streamsize>(json.size()))) {
+        std::cerr << "Could not write trace file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
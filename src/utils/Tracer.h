@@ -0,0 +1,86 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/**
+ * @brief Records scoped spans and writes them as a Chrome trace (chrome://tracing, Perfetto)
+ *
+ * Spans are buffered per thread while tracing is on and written out as one JSON file by
+ * finish(). Tracing is off unless start() is called, and a disabled span costs one relaxed
+ * atomic load. Use TRACE_SCOPE("Class::method") at the top of a scope to record it.
+ */
+class Tracer {
+public:
+    /**
+     * @brief Records the lifetime of a scope as one trace event
+     */
+    class Span {
+    public:
+        /**
+         * @brief Start a span
+         * @param name Event name; must be a string literal, only the pointer is kept
+         */
+        explicit Span(const char* name) : name(name), active(Tracer::isEnabled()) {
+            if (active) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Span() {
+            if (active) {
+                Tracer::record(name, start, std::chrono::steady_clock::now());
+            }
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* name;
+        bool active;                                  // Whether tracing was on at the start
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * @brief Start recording spans; the calling thread is shown as the main thread
+     * @param path File the trace is written to by finish()
+     */
+    static void start(const std::string& path);
+
+    /**
+     * @brief Stop recording and write every span recorded so far
+     * @return true if the trace was written or tracing was never started
+     */
+    static bool finish();
+
+    /**
+     * @brief Check whether spans are being recorded
+     * @return true between start() and finish()
+     */
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Record one completed span on the calling thread
+     * @param name Event name (string literal)
+     * @param begin When the span started
+     * @param end When the span ended
+     */
+    static void record(const char* name, std::chrono::steady_clock::time_point begin,
+                       std::chrono::steady_clock::time_point end);
+
+private:
+    static inline std::atomic<bool> enabled{false};
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/**
+ * @brief Trace the enclosing scope under the given name
+ */
+#define TRACE_SCOPE(name) Tracer::Span TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#endif // TRACER_H